@@ -1,5 +1,5 @@
 // Purpose and Main Use of the Code
-// The provided code implements three disk scheduling algorithms: SSTF (Shortest Seek Time First), SCAN, and C-LOOK. It presents a menu to the user to choose an algorithm, takes input for the number of requests and their positions, and calculates the total head movement for each algorithm.
+// The provided code implements disk scheduling algorithms: SSTF (Shortest Seek Time First), SCAN, C-LOOK, FCFS, C-SCAN, LOOK, N-step SCAN, F-SCAN and a Linux-style deadline scheduler. It presents a menu to the user to choose an algorithm, takes input for the number of requests and their positions, and calculates the total head movement for each algorithm.
 
 // Libraries Used
 // stdio.h: For input and output functions like printf() and scanf().
@@ -9,11 +9,27 @@
 // Copy code
 #include <stdio.h>  // Include standard I/O library for input and output functions
 #include <stdlib.h> // Include standard library for memory allocation and process control functions
+#include <math.h>   // pow() for the seek-time curve
+#include <pthread.h> // Submitter and hardware queue threads for the multi-queue simulation
+#include <sched.h>  // sched_yield() while a queue is full or empty
+#include <stdatomic.h> // Lock-free submission queue indexes
+#include <time.h>   // clock_gettime() for device timing
+
+#define MAX_REQUESTS 100 // Largest request queue accepted from the keyboard
 
 // Function prototypes for the disk scheduling algorithms
 int SSTF(); 
 int SCAN(); 
 int CLOOK(); 
+int FCFS();
+int CSCAN();
+int LOOK();
+int NSTEPSCAN();
+int FSCAN();
+int DEADLINE();
+int SIMULATE();
+int MULTIQUEUE();
+int BENCHMARK();
 
 int main() {
     int ch, YN = 1, i, l, f; // Variable declaration
@@ -26,7 +42,8 @@ int main() {
         //system("clear"); // Optional: clear the screen (commented out)
         // Display menu for user to choose a disk scheduling algorithm
         printf("\n\n\t*********** MENU ***********"); 
-        printf("\n\n\t1:SSTF\n\n\t2:SCAN\n\n\t3:CLOOK\n\n\t4:EXIT"); 
+        printf("\n\n\t1:SSTF\n\n\t2:SCAN\n\n\t3:CLOOK\n\n\t4:FCFS\n\n\t5:CSCAN\n\n\t6:LOOK");
+        printf("\n\n\t7:N-STEP SCAN\n\n\t8:FSCAN\n\n\t9:DEADLINE\n\n\t10:SIMULATE TRACE\n\n\t11:MULTI-QUEUE\n\n\t12:BENCHMARK\n\n\t0:EXIT");
         printf("\n\n\tEnter your choice: ");
         scanf("%d", &ch); // Read user choice
 
@@ -50,7 +67,34 @@ int main() {
                 }
                 CLOOK(); // Call CLOOK function
                 break;
-            case 4: // If EXIT is chosen
+            case 4: // If FCFS is chosen
+                FCFS();
+                break;
+            case 5: // If C-SCAN is chosen
+                CSCAN();
+                break;
+            case 6: // If LOOK is chosen
+                LOOK();
+                break;
+            case 7: // If N-step SCAN is chosen
+                NSTEPSCAN();
+                break;
+            case 8: // If F-SCAN is chosen
+                FSCAN();
+                break;
+            case 9: // If DEADLINE is chosen
+                DEADLINE();
+                break;
+            case 10: // If the trace simulation is chosen
+                SIMULATE();
+                break;
+            case 11: // If the multi-queue simulation is chosen
+                MULTIQUEUE();
+                break;
+            case 12: // If the benchmark is chosen
+                BENCHMARK();
+                break;
+            case 0: // If EXIT is chosen
                 exit(0); // Terminate the program
         } 
 
@@ -218,6 +262,913 @@ int CLOOK() {
     printf("Total head movement is %d", TotalHeadMoment); // Print total head movement
     return 0; // Return to the main function
 }
+
+// Helpers shared by the algorithms below. Every *Path() function fills path[]
+// with the positions the head visits in order (requests and disk edges) and
+// returns how many it wrote, so all of them report head movement the same way.
+// path[] must have room for 3 * n + 4 entries.
+
+// Read the request sequence and initial head position used by every algorithm
+int readRequests(int RQ[], int *initial) {
+    int i, n;
+    printf("Enter the number of Requests\n");
+    scanf("%d", &n); // Read number of requests
+    if (n > MAX_REQUESTS) n = MAX_REQUESTS; // Clamp to the size of RQ[]
+    printf("Enter the Requests sequence\n");
+    for (i = 0; i < n; i++) {
+        scanf("%d", &RQ[i]); // Read each request position
+    }
+    printf("Enter initial head position\n");
+    scanf("%d", initial); // Read initial head position
+    return n;
+}
+
+// Read the disk size and starting direction used by the sweeping algorithms
+void readGeometry(int *size, int *move) {
+    printf("Enter total disk size\n");
+    scanf("%d", size); // Read total disk size
+    printf("Enter the head movement direction for high 1 and for low 0\n");
+    scanf("%d", move); // Read head movement direction
+}
+
+int byCylinder(const void *a, const void *b) {
+    return *(const int *)a - *(const int *)b;
+}
+
+// Sort requests in ascending order. qsort rather than the bubble sort in SCAN and
+// CLOOK so the benchmark measures the policies, not the sort.
+void sortRequests(int RQ[], int n) {
+    qsort(RQ, n, sizeof(int), byCylinder);
+}
+
+// Total distance travelled by a head starting at initial and visiting path[0..k-1]
+int pathMovement(int initial, int path[], int k) {
+    int i, total = 0;
+    for (i = 0; i < k; i++) {
+        total += abs(path[i] - initial); // Distance to the next stop
+        initial = path[i]; // Head is now at that stop
+    }
+    return total;
+}
+
+// FCFS: service requests in the order they arrived
+int fcfsPath(int RQ[], int n, int path[]) {
+    int i;
+    for (i = 0; i < n; i++)
+        path[i] = RQ[i];
+    return n;
+}
+
+// C-SCAN: sweep to the end in one direction, jump to the other end and sweep again
+int cscanPath(int RQ[], int n, int initial, int size, int move, int path[]) {
+    int *S = malloc(n * sizeof(int)), i, k = 0, lo = 0, hi = 0;
+    for (i = 0; i < n; i++) S[i] = RQ[i];
+    sortRequests(S, n);
+    while (lo < n && S[lo] < initial) lo++; // Requests below the head
+    hi = lo;
+    while (hi < n && S[hi] <= initial) hi++; // Requests at or below the head
+
+    if (move == 1) {
+        for (i = lo; i < n; i++) path[k++] = S[i]; // Serve requests above the head
+        if (lo > 0) {
+            path[k++] = size - 1; // Run to the end of the disk
+            path[k++] = 0; // Return to the start
+            for (i = 0; i < lo; i++) path[k++] = S[i]; // Serve the rest upwards
+        }
+    } else {
+        for (i = hi - 1; i >= 0; i--) path[k++] = S[i]; // Serve requests below the head
+        if (hi < n) {
+            path[k++] = 0; // Run to the start of the disk
+            path[k++] = size - 1; // Return to the end
+            for (i = n - 1; i >= hi; i--) path[k++] = S[i]; // Serve the rest downwards
+        }
+    }
+    free(S);
+    return k;
+}
+
+// LOOK: like SCAN, but reverse at the last request instead of the disk edge
+int lookPath(int RQ[], int n, int initial, int move, int path[]) {
+    int *S = malloc(n * sizeof(int)), i, k = 0, lo = 0, hi = 0;
+    for (i = 0; i < n; i++) S[i] = RQ[i];
+    sortRequests(S, n);
+    while (lo < n && S[lo] < initial) lo++;
+    hi = lo;
+    while (hi < n && S[hi] <= initial) hi++;
+
+    if (move == 1) {
+        for (i = lo; i < n; i++) path[k++] = S[i]; // Serve upwards
+        for (i = lo - 1; i >= 0; i--) path[k++] = S[i]; // Reverse and serve downwards
+    } else {
+        for (i = hi - 1; i >= 0; i--) path[k++] = S[i]; // Serve downwards
+        for (i = hi; i < n; i++) path[k++] = S[i]; // Reverse and serve upwards
+    }
+    free(S);
+    return k;
+}
+
+// One SCAN sweep over a batch B[0..cnt-1] (sorted in place). The head keeps its
+// current direction, runs to the disk edge only if requests remain behind it,
+// and the direction it finishes in carries over to the next batch.
+int sweepBatch(int B[], int cnt, int *head, int *move, int size, int path[], int k) {
+    int i, lo = 0, hi = 0;
+    if (cnt == 0) return k;
+    sortRequests(B, cnt);
+    while (lo < cnt && B[lo] < *head) lo++;
+    hi = lo;
+    while (hi < cnt && B[hi] <= *head) hi++;
+
+    if (*move == 1) {
+        for (i = lo; i < cnt; i++) path[k++] = B[i];
+        if (lo > 0) {
+            path[k++] = size - 1; // Reach the end before reversing
+            for (i = lo - 1; i >= 0; i--) path[k++] = B[i];
+            *move = 0;
+        }
+    } else {
+        for (i = hi - 1; i >= 0; i--) path[k++] = B[i];
+        if (hi < cnt) {
+            path[k++] = 0; // Reach the start before reversing
+            for (i = hi; i < cnt; i++) path[k++] = B[i];
+            *move = 1;
+        }
+    }
+    *head = path[k - 1];
+    return k;
+}
+
+// N-step SCAN: split the queue into groups of N in arrival order and SCAN each
+// group completely before looking at the next one
+int nstepPath(int RQ[], int n, int initial, int size, int move, int N, int path[]) {
+    int *B = malloc(n * sizeof(int)), i, j, cnt, k = 0, head = initial;
+    if (N < 1) N = 1;
+    for (i = 0; i < n; i += N) {
+        cnt = (n - i < N) ? n - i : N;
+        for (j = 0; j < cnt; j++) B[j] = RQ[i + j]; // Next group of N requests
+        k = sweepBatch(B, cnt, &head, &move, size, path, k);
+    }
+    free(B);
+    return k;
+}
+
+// F-SCAN: request i arrives after i * gap cylinders of head travel. Each sweep
+// serves only the requests that had arrived when it started; anything arriving
+// during the sweep waits in the second queue for the next one.
+int fscanPath(int RQ[], int n, int initial, int size, int move, int gap, int path[]) {
+    int *B = malloc(n * sizeof(int)), cnt, k = 0, head = initial, start;
+    long now = 0; // Time measured in cylinders of head travel
+    int next = 0; // First request that has not been queued yet
+    while (next < n) {
+        if ((long)next * gap > now) now = (long)next * gap; // Idle until the next arrival
+        cnt = 0;
+        while (next < n && (long)next * gap <= now) B[cnt++] = RQ[next++]; // Freeze the queue
+        start = k;
+        k = sweepBatch(B, cnt, &head, &move, size, path, k);
+        now += pathMovement(start > 0 ? path[start - 1] : initial, path + start, k - start);
+    }
+    free(B);
+    return k;
+}
+
+// Pending request of direction dir (0 read, 1 write) with the lowest position at
+// or above pos, or -1. Deadline dispatches in one-way ascending sector order.
+int nextSorted(int RQ[], int type[], int done[], int arrived, int dir, int pos) {
+    int i, best = -1;
+    for (i = 0; i < arrived; i++) {
+        if (!done[i] && type[i] == dir && RQ[i] >= pos && (best < 0 || RQ[i] < RQ[best]))
+            best = i;
+    }
+    return best;
+}
+
+// Oldest pending request of direction dir, i.e. the head of its FIFO, or -1
+int fifoHead(int type[], int done[], int arrived, int dir) {
+    int i;
+    for (i = 0; i < arrived; i++) {
+        if (!done[i] && type[i] == dir) return i;
+    }
+    return -1;
+}
+
+// Deadline: reads and writes are kept both in sector order and in FIFO order
+// with an expiry time. Batches of up to fifoBatch requests go out in sector
+// order; a new batch starts from the FIFO head if it has expired. Reads are
+// preferred, but writes get a batch after writesStarved read batches. Request i
+// arrives after i * gap cylinders of head travel. *expired counts requests that
+// completed after their deadline.
+int deadlinePath(int RQ[], int type[], int n, int initial, int gap, int readExpire, int writeExpire,
+                 int fifoBatch, int writesStarved, int path[], int *expired) {
+    int *done = calloc(n, sizeof(int)), k = 0, head = initial, served = 0, arrived = 0;
+    int dir = -1, batching = 0, starved = 0, rq, d, reads, writes;
+    long now = 0; // Time measured in cylinders of head travel
+    *expired = 0;
+    while (served < n) {
+        while (arrived < n && (long)arrived * gap <= now) arrived++; // Queue new arrivals
+        reads = fifoHead(type, done, arrived, 0) >= 0;
+        writes = fifoHead(type, done, arrived, 1) >= 0;
+        if (!reads && !writes) {
+            now = (long)arrived * gap; // Idle until the next arrival
+            continue;
+        }
+
+        rq = -1;
+        if (dir >= 0 && batching < fifoBatch)
+            rq = nextSorted(RQ, type, done, arrived, dir, head); // Continue the current batch
+        if (rq < 0) {
+            if (reads && !(writes && starved >= writesStarved)) {
+                if (writes) starved++; // Writes passed over once more
+                dir = 0;
+            } else {
+                starved = 0;
+                dir = 1;
+            }
+            rq = fifoHead(type, done, arrived, dir);
+            d = (dir == 0) ? readExpire : writeExpire;
+            if ((long)rq * gap + d > now) { // FIFO head not expired: keep sector order
+                int s = nextSorted(RQ, type, done, arrived, dir, head);
+                if (s >= 0) rq = s;
+            }
+            batching = 0;
+        }
+
+        path[k++] = RQ[rq];
+        now += abs(RQ[rq] - head); // Seek to the request
+        head = RQ[rq];
+        done[rq] = 1;
+        served++;
+        batching++;
+        d = (type[rq] == 0) ? readExpire : writeExpire;
+        if (now > (long)rq * gap + d) (*expired)++;
+    }
+    free(done);
+    return k;
+}
+
+// FCFS Algorithm
+int FCFS() {
+    int RQ[MAX_REQUESTS], path[3 * MAX_REQUESTS + 4], n, initial, k;
+    n = readRequests(RQ, &initial);
+    k = fcfsPath(RQ, n, path);
+    printf("Total head movement is %d", pathMovement(initial, path, k));
+    return 0;
+}
+
+// C-SCAN Algorithm
+int CSCAN() {
+    int RQ[MAX_REQUESTS], path[3 * MAX_REQUESTS + 4], n, initial, size, move, k;
+    n = readRequests(RQ, &initial);
+    readGeometry(&size, &move);
+    k = cscanPath(RQ, n, initial, size, move, path);
+    printf("Total head movement is %d", pathMovement(initial, path, k));
+    return 0;
+}
+
+// LOOK Algorithm
+int LOOK() {
+    int RQ[MAX_REQUESTS], path[3 * MAX_REQUESTS + 4], n, initial, size, move, k;
+    n = readRequests(RQ, &initial);
+    readGeometry(&size, &move);
+    k = lookPath(RQ, n, initial, move, path);
+    printf("Total head movement is %d", pathMovement(initial, path, k));
+    return 0;
+}
+
+// N-step SCAN Algorithm
+int NSTEPSCAN() {
+    int RQ[MAX_REQUESTS], path[3 * MAX_REQUESTS + 4], n, initial, size, move, N, k;
+    n = readRequests(RQ, &initial);
+    readGeometry(&size, &move);
+    printf("Enter the group size N\n");
+    scanf("%d", &N); // Requests per SCAN group
+    k = nstepPath(RQ, n, initial, size, move, N, path);
+    printf("Total head movement is %d", pathMovement(initial, path, k));
+    return 0;
+}
+
+// F-SCAN Algorithm
+int FSCAN() {
+    int RQ[MAX_REQUESTS], path[3 * MAX_REQUESTS + 4], n, initial, size, move, gap, k;
+    n = readRequests(RQ, &initial);
+    readGeometry(&size, &move);
+    printf("Enter the arrival gap between requests in cylinders of head travel (0 if all are queued)\n");
+    scanf("%d", &gap);
+    k = fscanPath(RQ, n, initial, size, move, gap, path);
+    printf("Total head movement is %d", pathMovement(initial, path, k));
+    return 0;
+}
+
+// Deadline Algorithm
+int DEADLINE() {
+    int RQ[MAX_REQUESTS], type[MAX_REQUESTS], path[3 * MAX_REQUESTS + 4];
+    int i, n, initial, gap, readExpire, writeExpire, fifoBatch, writesStarved, expired, k;
+    n = readRequests(RQ, &initial);
+    printf("Enter the type of each request (0 for read, 1 for write)\n");
+    for (i = 0; i < n; i++) {
+        scanf("%d", &type[i]); // Read or write
+    }
+    printf("Enter the arrival gap between requests in cylinders of head travel (0 if all are queued)\n");
+    scanf("%d", &gap);
+    printf("Enter read expiry and write expiry in cylinders of head travel (e.g. 500 5000)\n");
+    scanf("%d %d", &readExpire, &writeExpire);
+    printf("Enter fifo batch size and writes starved limit (e.g. 16 2)\n");
+    scanf("%d %d", &fifoBatch, &writesStarved);
+    k = deadlinePath(RQ, type, n, initial, gap, readExpire, writeExpire, fifoBatch, writesStarved, path, &expired);
+    printf("Total head movement is %d", pathMovement(initial, path, k));
+    printf("\nRequests served after their deadline: %d", expired);
+    return 0;
+}
+
+// Online simulation. Requests come from a trace file and arrive over time, so
+// the scheduler only ever sees the requests that are already queued. Each
+// service costs seek + rotational latency + transfer time, and the result is
+// reported as latency percentiles and IOPS rather than head movement.
+
+typedef struct {
+    double arrival; // Arrival time in ms
+    int cylinder;   // Target cylinder
+    int kb;         // Transfer size in KB
+    int type;       // 0 read, 1 write
+    double finish;  // Completion time in ms (filled by the simulator)
+} IORequest;
+
+typedef struct {
+    int size;           // Number of cylinders
+    int policy;         // 1 FCFS, 2 SSTF, 3 SCAN, 4 C-LOOK, 5 DEADLINE
+    double trackMs;     // Seek time for a distance of one cylinder
+    double strokeMs;    // Seek time for a full-stroke seek
+    double shape;       // Seek curve exponent (0.5 square root, 1 linear)
+    double rpm;         // Spindle speed
+    double mbps;        // Media transfer rate in MB/s
+    double readExpire;  // DEADLINE: read expiry in ms
+    double writeExpire; // DEADLINE: write expiry in ms
+} DiskModel;
+
+// DEADLINE: after serving an expired request, serve this many in sector order
+// before looking at deadlines again, so an overloaded queue does not turn into
+// pure deadline order with long seeks. An expired request can therefore wait
+// behind up to ONLINE_FIFO_BATCH - 1 sorted picks.
+#define ONLINE_FIFO_BATCH 16
+
+// Seek time for a distance of d cylinders on the configured curve
+double seekTime(DiskModel *dm, int d) {
+    if (d == 0) return 0;
+    if (d == 1 || dm->size <= 2) return dm->trackMs;
+    return dm->trackMs + (dm->strokeMs - dm->trackMs) * pow((double)(d - 1) / (dm->size - 2), dm->shape);
+}
+
+// Load "arrival_ms cylinder kb type" lines; lines starting with '#' are skipped
+IORequest *loadTrace(const char *file, int *n) {
+    FILE *fp = fopen(file, "r");
+    IORequest *rq = NULL;
+    char line[256];
+    int cap = 0;
+    *n = 0;
+    if (fp == NULL) {
+        perror("Failed to open trace");
+        return NULL;
+    }
+    while (fgets(line, sizeof(line), fp)) {
+        IORequest r = {0, 0, 4, 0, 0};
+        if (line[0] == '#' || sscanf(line, "%lf %d %d %d", &r.arrival, &r.cylinder, &r.kb, &r.type) < 2)
+            continue; // Comment or blank line
+        if (*n == cap) {
+            cap = cap ? cap * 2 : 64;
+            rq = realloc(rq, cap * sizeof(IORequest));
+        }
+        rq[(*n)++] = r;
+    }
+    fclose(fp);
+    return rq;
+}
+
+int byArrival(const void *a, const void *b) {
+    double x = ((const IORequest *)a)->arrival, y = ((const IORequest *)b)->arrival;
+    return (x > y) - (x < y);
+}
+
+int byValue(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Choose which queued request to serve next. q[] holds indexes into rq[] in
+// arrival order; *dir is the sweep direction for SCAN (1 up, 0 down) and
+// *batching counts DEADLINE picks since the last expired request was served.
+int pickOnline(DiskModel *dm, IORequest rq[], int q[], int qn, int head, int *dir, int *batching, double now) {
+    int i, best = -1, d, bestd = 0;
+    switch (dm->policy) {
+        case 1: // FCFS: oldest request
+            return 0;
+        case 2: // SSTF: nearest request
+            for (i = 0; i < qn; i++) {
+                d = abs(rq[q[i]].cylinder - head);
+                if (best < 0 || d < bestd) { best = i; bestd = d; }
+            }
+            return best;
+        case 3: // SCAN: nearest request in the sweep direction, reversing at the last one
+            for (int pass = 0; pass < 2 && best < 0; pass++) {
+                for (i = 0; i < qn; i++) {
+                    d = rq[q[i]].cylinder - head;
+                    if (*dir == 0) d = -d;
+                    if (d >= 0 && (best < 0 || d < bestd)) { best = i; bestd = d; }
+                }
+                if (best < 0) *dir = !*dir; // Nothing ahead: turn around
+            }
+            return best;
+        case 5: // DEADLINE: serve the expired request with the earliest deadline, then a batch in C-LOOK order
+            if (++*batching >= ONLINE_FIFO_BATCH) {
+                double due, bestdue = 0;
+                for (i = 0; i < qn; i++) {
+                    due = rq[q[i]].arrival + (rq[q[i]].type ? dm->writeExpire : dm->readExpire);
+                    if (due <= now && (best < 0 || due < bestdue)) { best = i; bestdue = due; }
+                }
+                if (best >= 0) {
+                    *batching = 0;
+                    return best;
+                }
+            }
+            /* fall through */ // Nothing expired, or still in a batch: C-LOOK order
+        default: // C-LOOK: nearest request at or above the head, else the lowest one
+            for (i = 0; i < qn; i++) {
+                d = rq[q[i]].cylinder - head;
+                if (d < 0) d += dm->size; // Wrap around to the start
+                if (best < 0 || d < bestd) { best = i; bestd = d; }
+            }
+            return best;
+    }
+}
+
+// Run the trace through the model. Returns total head movement; fills in
+// rq[].finish. rq[] must be sorted by arrival time.
+long simulateTrace(DiskModel *dm, IORequest rq[], int n, int initial) {
+    int *q = malloc(n * sizeof(int)), qn = 0, next = 0, done = 0, head = initial, dir = 1, i, pick;
+    int batching = ONLINE_FIFO_BATCH; // Check deadlines from the first pick
+    double now = 0, revMs = 60000.0 / dm->rpm;
+    long movement = 0;
+    srand(1); // Same rotational positions on every run
+    while (done < n) {
+        while (next < n && rq[next].arrival <= now) q[qn++] = next++; // Queue arrivals
+        if (qn == 0) {
+            now = rq[next].arrival; // Disk idles until the next arrival
+            continue;
+        }
+        pick = pickOnline(dm, rq, q, qn, head, &dir, &batching, now);
+        IORequest *r = &rq[q[pick]];
+        for (i = pick; i < qn - 1; i++) q[i] = q[i + 1]; // Keep the queue in arrival order
+        qn--;
+
+        movement += abs(r->cylinder - head);
+        now += seekTime(dm, abs(r->cylinder - head)); // Seek
+        now += revMs * rand() / ((double)RAND_MAX + 1); // Wait for the sector to come round
+        now += r->kb / 1024.0 / dm->mbps * 1000.0; // Transfer
+        head = r->cylinder;
+        r->finish = now;
+        done++;
+    }
+    free(q);
+    return movement;
+}
+
+// Nearest-rank percentile of sorted values v[0..n-1]
+double percentile(double v[], int n, double p) {
+    int k = (int)(p / 100.0 * n + 0.999999);
+    if (k < 1) k = 1;
+    if (k > n) k = n;
+    return v[k - 1];
+}
+
+// Time-based simulation from a trace file
+int SIMULATE() {
+    DiskModel dm = {0};
+    char file[256];
+    int n, i, initial;
+    printf("Enter trace file name (lines of: arrival_ms cylinder kb type[0 read, 1 write])\n");
+    scanf("%255s", file);
+    IORequest *rq = loadTrace(file, &n);
+    if (rq == NULL || n == 0) {
+        printf("Trace is empty");
+        free(rq);
+        return 0;
+    }
+    qsort(rq, n, sizeof(IORequest), byArrival);
+
+    printf("Enter initial head position and total disk size\n");
+    scanf("%d %d", &initial, &dm.size);
+    printf("Enter policy: 1 FCFS, 2 SSTF, 3 SCAN, 4 C-LOOK, 5 DEADLINE\n");
+    scanf("%d", &dm.policy);
+    if (dm.policy == 5) {
+        printf("Enter read expiry and write expiry in ms (e.g. 500 5000)\n");
+        scanf("%lf %lf", &dm.readExpire, &dm.writeExpire);
+    }
+    printf("Enter track-to-track seek ms, full-stroke seek ms and curve exponent (e.g. 0.8 15 0.5)\n");
+    scanf("%lf %lf %lf", &dm.trackMs, &dm.strokeMs, &dm.shape);
+    printf("Enter RPM and transfer rate in MB/s (e.g. 7200 150)\n");
+    scanf("%lf %lf", &dm.rpm, &dm.mbps);
+
+    long movement = simulateTrace(&dm, rq, n, initial);
+
+    double *lat = malloc(n * sizeof(double)), sum = 0, end = 0;
+    for (i = 0; i < n; i++) {
+        lat[i] = rq[i].finish - rq[i].arrival; // Queueing + service time
+        sum += lat[i];
+        if (rq[i].finish > end) end = rq[i].finish;
+    }
+    qsort(lat, n, sizeof(double), byValue);
+    printf("Requests: %d  Elapsed: %.3f ms  IOPS: %.1f\n", n, end - rq[0].arrival,
+           end > rq[0].arrival ? n * 1000.0 / (end - rq[0].arrival) : 0);
+    printf("Latency ms: mean %.3f  p50 %.3f  p99 %.3f  p999 %.3f  max %.3f\n", sum / n,
+           percentile(lat, n, 50), percentile(lat, n, 99), percentile(lat, n, 99.9), lat[n - 1]);
+    printf("Total head movement is %ld", movement);
+    free(lat);
+    free(rq);
+    return 0;
+}
+
+// Multi-queue block layer simulation. Each submitter thread plugs its requests
+// into a private batch, back-merges sequential ones, and flushes the batch into
+// its own lock-free single-producer/single-consumer submission queue with one
+// release store. Hardware queue threads each own a subset of the submission
+// queues and "execute" commands by spinning for the modelled device time.
+// Mode 0 replaces the per-CPU queues with one mutex-protected queue, which is
+// the single-queue model the other algorithms in this file assume.
+
+#define SQ_DEPTH 1024          // Slots per submission queue (power of two)
+#define MQ_DISK_SECTORS (1L << 30) // Sectors on the simulated device
+#define MQ_MAX_MERGE 256       // Largest merged command in sectors (128 KB)
+
+typedef struct {
+    long sector; // Starting sector
+    int len;     // Length in sectors
+    int count;   // Original requests merged into this command
+} BlockRq;
+
+typedef struct {
+    _Atomic unsigned head; // Next slot the hardware queue reads
+    char pad1[64 - sizeof(unsigned)];
+    _Atomic unsigned tail; // Next slot the submitter writes
+    char pad2[64 - sizeof(unsigned)];
+    BlockRq slot[SQ_DEPTH];
+} SubmitQueue;
+
+struct {
+    int threads, hwq, perThread, plug, seqPct, mode;
+    double cmdUs, usPerKb;
+    SubmitQueue *sq;             // One per submitter (mode 1)
+    BlockRq *shared;             // Single shared ring (mode 0)
+    unsigned sharedHead, sharedTail;
+    pthread_mutex_t lock;        // Protects the shared ring
+    _Atomic int submittersLeft;  // Submitters that have not finished yet
+    _Atomic long completed;      // Original requests completed
+    _Atomic long commands;       // Commands issued to the device after merging
+} mq;
+
+double nowUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// Move a plugged batch into the submitter's queue and publish it at once
+void mqFlush(int id, BlockRq batch[], int cnt) {
+    int i = 0;
+    if (mq.mode == 0) {
+        while (i < cnt) {
+            pthread_mutex_lock(&mq.lock);
+            while (i < cnt && mq.sharedTail - mq.sharedHead < SQ_DEPTH)
+                mq.shared[mq.sharedTail++ % SQ_DEPTH] = batch[i++];
+            pthread_mutex_unlock(&mq.lock);
+            if (i < cnt) sched_yield(); // Queue full: let the device catch up
+        }
+        return;
+    }
+    SubmitQueue *q = &mq.sq[id];
+    unsigned tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    while (i < cnt) {
+        unsigned head = atomic_load_explicit(&q->head, memory_order_acquire);
+        while (i < cnt && tail - head < SQ_DEPTH)
+            q->slot[tail++ % SQ_DEPTH] = batch[i++];
+        atomic_store_explicit(&q->tail, tail, memory_order_release); // Doorbell
+        if (i < cnt) sched_yield();
+    }
+}
+
+void *mqSubmitter(void *arg) {
+    int id = (int)(long)arg, r, cnt = 0;
+    unsigned seed = id + 1;
+    BlockRq *batch = malloc(mq.plug * sizeof(BlockRq));
+    long sector = ((long)rand_r(&seed) << 8) % MQ_DISK_SECTORS;
+    for (r = 0; r < mq.perThread; r++) {
+        if ((int)(rand_r(&seed) % 100) >= mq.seqPct)
+            sector = ((long)rand_r(&seed) << 8) % MQ_DISK_SECTORS; // Random 4 KB read
+        BlockRq *last = cnt ? &batch[cnt - 1] : NULL;
+        if (last && last->sector + last->len == sector && last->len + 8 <= MQ_MAX_MERGE) {
+            last->len += 8; // Back-merge into the plugged request
+            last->count++;
+        } else {
+            batch[cnt].sector = sector;
+            batch[cnt].len = 8;
+            batch[cnt].count = 1;
+            cnt++;
+        }
+        sector += 8;
+        if (cnt == mq.plug) { // Unplug
+            mqFlush(id, batch, cnt);
+            cnt = 0;
+        }
+    }
+    mqFlush(id, batch, cnt);
+    free(batch);
+    atomic_fetch_sub(&mq.submittersLeft, 1);
+    return NULL;
+}
+
+// Take one command for hardware queue h; returns 0 if none was waiting
+int mqTake(int h, BlockRq *out) {
+    int s;
+    if (mq.mode == 0) {
+        int got = 0;
+        pthread_mutex_lock(&mq.lock);
+        if (mq.sharedHead != mq.sharedTail) {
+            *out = mq.shared[mq.sharedHead++ % SQ_DEPTH];
+            got = 1;
+        }
+        pthread_mutex_unlock(&mq.lock);
+        return got;
+    }
+    for (s = h; s < mq.threads; s += mq.hwq) { // Submission queues mapped to this hardware queue
+        SubmitQueue *q = &mq.sq[s];
+        unsigned head = atomic_load_explicit(&q->head, memory_order_relaxed);
+        if (head != atomic_load_explicit(&q->tail, memory_order_acquire)) {
+            *out = q->slot[head % SQ_DEPTH];
+            atomic_store_explicit(&q->head, head + 1, memory_order_release);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void *mqHardware(void *arg) {
+    int h = (int)(long)arg;
+    BlockRq c;
+    while (1) {
+        int left = atomic_load(&mq.submittersLeft); // Read before checking the queues
+        if (mqTake(h, &c)) {
+            double until = nowUs() + mq.cmdUs + c.len / 2.0 * mq.usPerKb;
+            while (nowUs() < until)
+                ; // Device is busy with this command
+            atomic_fetch_add(&mq.completed, c.count);
+            atomic_fetch_add(&mq.commands, 1);
+        } else if (left == 0) {
+            break; // Every submitter is done and our queues are drained
+        } else {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+// Run one configuration and return requests completed per second
+double mqRun(int threads) {
+    pthread_t *tid = malloc((threads + mq.hwq) * sizeof(pthread_t));
+    int i;
+    mq.threads = threads;
+    mq.sq = aligned_alloc(64, threads * sizeof(SubmitQueue));
+    for (i = 0; i < threads; i++) {
+        atomic_init(&mq.sq[i].head, 0);
+        atomic_init(&mq.sq[i].tail, 0);
+    }
+    mq.sharedHead = mq.sharedTail = 0;
+    atomic_store(&mq.submittersLeft, threads);
+    atomic_store(&mq.completed, 0);
+    atomic_store(&mq.commands, 0);
+
+    double start = nowUs();
+    for (i = 0; i < mq.hwq; i++) pthread_create(&tid[threads + i], NULL, mqHardware, (void *)(long)i);
+    for (i = 0; i < threads; i++) pthread_create(&tid[i], NULL, mqSubmitter, (void *)(long)i);
+    for (i = 0; i < threads + mq.hwq; i++) pthread_join(tid[i], NULL);
+    double elapsed = nowUs() - start;
+
+    free(mq.sq);
+    free(tid);
+    return atomic_load(&mq.completed) * 1e6 / elapsed;
+}
+
+// Multi-queue scaling run
+int MULTIQUEUE() {
+    int maxThreads, t;
+    double base = 0, iops;
+    printf("Enter max submitter threads and number of hardware queues\n");
+    scanf("%d %d", &maxThreads, &mq.hwq);
+    printf("Enter requests per thread, plug batch size and percent sequential requests\n");
+    scanf("%d %d %d", &mq.perThread, &mq.plug, &mq.seqPct);
+    printf("Enter device time per command and per KB in microseconds (e.g. 10 0.05)\n");
+    scanf("%lf %lf", &mq.cmdUs, &mq.usPerKb);
+    printf("Enter queue mode: 1 per-CPU multi-queue, 0 single shared queue\n");
+    scanf("%d", &mq.mode);
+    if (maxThreads < 1 || mq.hwq < 1 || mq.plug < 1) {
+        printf("Threads, hardware queues and plug size must be at least 1");
+        return 0;
+    }
+    mq.shared = malloc(SQ_DEPTH * sizeof(BlockRq));
+    pthread_mutex_init(&mq.lock, NULL);
+
+    printf("\nThreads\tIOPS\t\tCommands\tMerged/cmd\tSpeedup\n");
+    for (t = 1; t <= maxThreads; t = (t * 2 > maxThreads && t < maxThreads) ? maxThreads : t * 2) {
+        iops = mqRun(t);
+        if (t == 1) base = iops;
+        printf("%d\t%.0f\t%ld\t\t%.2f\t\t%.2fx\n", t, iops, atomic_load(&mq.commands),
+               (double)atomic_load(&mq.completed) / atomic_load(&mq.commands), iops / base);
+    }
+    pthread_mutex_destroy(&mq.lock);
+    free(mq.shared);
+    return 0;
+}
+
+// Benchmark mode. One synthetic stream is generated and fed to every algorithm
+// through its *Path() function; the head timelines and the CPU time each
+// algorithm spends deciding the order are written to CSV files.
+
+// SSTF on the same path interface (uses flags instead of the 1000 sentinel)
+int sstfPath(int RQ[], int n, int initial, int path[]) {
+    int *done = calloc(n, sizeof(int)), i, k, best, d, bestd = 0;
+    for (k = 0; k < n; k++) {
+        best = -1;
+        for (i = 0; i < n; i++) {
+            d = abs(RQ[i] - initial);
+            if (!done[i] && (best < 0 || d < bestd)) { best = i; bestd = d; }
+        }
+        done[best] = 1;
+        path[k] = initial = RQ[best];
+    }
+    free(done);
+    return n;
+}
+
+// SCAN on the path interface: like SCAN() it always runs to the disk edge
+int scanPath(int RQ[], int n, int initial, int size, int move, int path[]) {
+    int *S = malloc(n * sizeof(int)), i, k = 0, lo = 0;
+    for (i = 0; i < n; i++) S[i] = RQ[i];
+    sortRequests(S, n);
+    while (lo < n && S[lo] <= initial) lo++; // First request above the head
+    if (move == 1) {
+        for (i = lo; i < n; i++) path[k++] = S[i];
+        path[k++] = size - 1;
+        for (i = lo - 1; i >= 0; i--) path[k++] = S[i];
+    } else {
+        for (i = lo - 1; i >= 0; i--) path[k++] = S[i];
+        path[k++] = 0;
+        for (i = lo; i < n; i++) path[k++] = S[i];
+    }
+    free(S);
+    return k;
+}
+
+// C-LOOK on the path interface
+int clookPath(int RQ[], int n, int initial, int move, int path[]) {
+    int *S = malloc(n * sizeof(int)), i, k = 0, lo = 0;
+    for (i = 0; i < n; i++) S[i] = RQ[i];
+    sortRequests(S, n);
+    while (lo < n && S[lo] <= initial) lo++;
+    if (move == 1) {
+        for (i = lo; i < n; i++) path[k++] = S[i];
+        for (i = 0; i < lo; i++) path[k++] = S[i]; // Jump back to the lowest request
+    } else {
+        for (i = lo - 1; i >= 0; i--) path[k++] = S[i];
+        for (i = n - 1; i >= lo; i--) path[k++] = S[i]; // Jump back to the highest request
+    }
+    free(S);
+    return k;
+}
+
+// Fill RQ[] with one of the synthetic workloads: 1 uniform, 2 Zipf hotspots
+// (cylinder popularity follows rank^-zipfS over a shuffled cylinder order),
+// 3 sequential runs of runLen consecutive cylinders. About 30% are writes.
+void generateStream(int kind, int RQ[], int type[], int n, int size, double zipfS, int runLen, unsigned seed) {
+    int i, j, pos = 0;
+    srand(seed);
+    if (kind == 2) {
+        double *cdf = malloc(size * sizeof(double)), sum = 0;
+        int *perm = malloc(size * sizeof(int));
+        for (i = 0; i < size; i++) {
+            sum += 1.0 / pow(i + 1, zipfS);
+            cdf[i] = sum;
+            perm[i] = i;
+        }
+        for (i = size - 1; i > 0; i--) { // Scatter the popular cylinders
+            j = rand() % (i + 1);
+            pos = perm[i]; perm[i] = perm[j]; perm[j] = pos;
+        }
+        for (i = 0; i < n; i++) {
+            double u = sum * rand() / ((double)RAND_MAX + 1);
+            int lo = 0, hi = size - 1;
+            while (lo < hi) { // First rank whose cdf exceeds u
+                int mid = (lo + hi) / 2;
+                if (cdf[mid] <= u) lo = mid + 1; else hi = mid;
+            }
+            RQ[i] = perm[lo];
+        }
+        free(cdf);
+        free(perm);
+    } else {
+        for (i = 0; i < n; i++) {
+            if (kind != 3 || runLen < 1 || i % runLen == 0 || pos >= size - 1)
+                pos = rand() % size; // Start a new run (or every request for uniform)
+            else
+                pos++;
+            RQ[i] = pos;
+        }
+    }
+    for (i = 0; i < n; i++)
+        type[i] = rand() % 10 < 3;
+}
+
+const char *algName[] = {"", "SSTF", "SCAN", "CLOOK", "FCFS", "CSCAN", "LOOK", "NSTEPSCAN", "FSCAN", "DEADLINE"};
+
+// Run algorithm alg (menu numbering) on the stream and return the path length
+int runPath(int alg, int RQ[], int type[], int n, int initial, int size, int gap, int path[]) {
+    int expired;
+    switch (alg) {
+        case 1: return sstfPath(RQ, n, initial, path);
+        case 2: return scanPath(RQ, n, initial, size, 1, path);
+        case 3: return clookPath(RQ, n, initial, 1, path);
+        case 4: return fcfsPath(RQ, n, path);
+        case 5: return cscanPath(RQ, n, initial, size, 1, path);
+        case 6: return lookPath(RQ, n, initial, 1, path);
+        case 7: return nstepPath(RQ, n, initial, size, 1, 16, path);
+        case 8: return fscanPath(RQ, n, initial, size, 1, gap, path);
+        default: return deadlinePath(RQ, type, n, initial, gap, size, 10 * size, 16, 2, path, &expired);
+    }
+}
+
+// Benchmark every algorithm on the same generated stream
+int BENCHMARK() {
+    int kind, n, size, initial, gap, runLen = 0, alg, i, k = 0, reps;
+    double zipfS = 1.0;
+    char prefix[200], file[256];
+    printf("Enter generator: 1 uniform, 2 hotspot (Zipf), 3 sequential runs\n");
+    scanf("%d", &kind);
+    if (kind == 2) {
+        printf("Enter Zipf exponent (e.g. 1.0)\n");
+        scanf("%lf", &zipfS);
+    } else if (kind == 3) {
+        printf("Enter run length\n");
+        scanf("%d", &runLen);
+    }
+    printf("Enter number of requests, total disk size and initial head position\n");
+    scanf("%d %d %d", &n, &size, &initial);
+    printf("Enter the arrival gap for FSCAN and DEADLINE in cylinders of head travel (0 if all are queued)\n");
+    scanf("%d", &gap);
+    printf("Enter output file prefix (writes <prefix>_timeline.csv and <prefix>_timing.csv)\n");
+    scanf("%199s", prefix);
+    if (n < 1 || size < 2) {
+        printf("Need at least one request and two cylinders");
+        return 0;
+    }
+
+    int *RQ = malloc(n * sizeof(int)), *type = malloc(n * sizeof(int));
+    int *path = malloc((3 * n + 4) * sizeof(int));
+    generateStream(kind, RQ, type, n, size, zipfS, runLen, 1);
+
+    sprintf(file, "%s_timeline.csv", prefix);
+    FILE *tl = fopen(file, "w");
+    sprintf(file, "%s_timing.csv", prefix);
+    FILE *tm = fopen(file, "w");
+    if (tl == NULL || tm == NULL) {
+        perror("Failed to open output file");
+        if (tl) fclose(tl);
+        if (tm) fclose(tm);
+        free(RQ); free(type); free(path);
+        return 0;
+    }
+    fprintf(tl, "algorithm,step,position\n");
+    fprintf(tm, "algorithm,requests,head_movement,cpu_us,ns_per_request\n");
+    printf("\nAlgorithm\tHead movement\tCPU us/run\tns/request\n");
+
+    for (alg = 1; alg <= 9; alg++) {
+        double start = nowUs(), elapsed;
+        reps = 0;
+        do { // Repeat short runs so the timing is measurable
+            k = runPath(alg, RQ, type, n, initial, size, gap, path);
+            reps++;
+            elapsed = nowUs() - start;
+        } while (elapsed < 20000 && reps < 1000);
+        double us = elapsed / reps;
+        int movement = pathMovement(initial, path, k);
+
+        fprintf(tl, "%s,0,%d\n", algName[alg], initial);
+        for (i = 0; i < k; i++)
+            fprintf(tl, "%s,%d,%d\n", algName[alg], i + 1, path[i]);
+        fprintf(tm, "%s,%d,%d,%.3f,%.1f\n", algName[alg], n, movement, us, us * 1000 / n);
+        printf("%-10s\t%d\t\t%.3f\t\t%.1f\n", algName[alg], movement, us, us * 1000 / n);
+    }
+    fclose(tl);
+    fclose(tm);
+    printf("Timeline written to %s_timeline.csv, timing to %s_timing.csv", prefix, prefix);
+    free(RQ);
+    free(type);
+    free(path);
+    return 0;
+}
 // Keywords and Their Explanations
 // #include <stdio.h>: A preprocessor directive to include the standard input-output library for functions like printf() and scanf().
 // #include <stdlib.h>: A preprocessor directive to include the standard library for functions like abs() (absolute value) and exit() (to terminate the program).
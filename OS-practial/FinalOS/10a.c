@@ -15,8 +15,16 @@
 #include <sys/shm.h>       // Include library for shared memory functions
 #include <stdlib.h>        // Include standard library for memory allocation and process control
 #include <string.h>        // Include library for string handling functions
+#include <sys/wait.h>      // waitpid for the producer processes in queue mode
+#include <time.h>          // clock_gettime for the queue benchmark
+#include "shmqueue.h"      // Shared-memory message queue (queue mode)
+
+int queuemain(int argc, char *argv[]); // Message-stream mode, selected by command-line arguments
+
+int main(int argc, char *argv[]) {
+    if (argc > 1 && strcmp(argv[1], "queue") == 0)
+        return queuemain(argc, argv);  // Stream messages to 10b through a shared-memory queue
 
-int main() {              
     // Create a unique key for the shared memory segment
     key_t key = ftok("shmfile", 65);  // Generate a unique key using the ftok function; "shmfile" is a pathname and 65 is a project identifier
     if (key == -1) {                   
@@ -49,6 +57,72 @@ int main() {
 
     return 0;                          // Return 0 to indicate successful completion of the program
 }
+
+double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Queue mode: ./10a queue <spsc|mpmc> <messages per producer> <message bytes> [producers] [slots]
+// Creates the queue segment and streams messages into it; run "./10b queue" to consume them.
+// Each message starts with a 64-bit number (unique across producers) and the rest of it is
+// filled with that number's low byte, so 10b can check both.
+int queuemain(int argc, char *argv[]) {
+    int kind = argc > 2 && strcmp(argv[2], "mpmc") == 0 ? SHMQ_MPMC : SHMQ_SPSC;
+    long messages = argc > 3 ? atol(argv[3]) : 1000000; // Per producer
+    int size = argc > 4 ? atoi(argv[4]) : 64;            // Bytes per message
+    int producers = argc > 5 ? atoi(argv[5]) : 1;
+    int slots = argc > 6 ? atoi(argv[6]) : 4096;
+    if (argc < 3 || (strcmp(argv[2], "spsc") != 0 && strcmp(argv[2], "mpmc") != 0) || messages < 1 ||
+        size < (int)sizeof(uint64_t) || producers < 1 || slots < 1 || (kind == SHMQ_SPSC && producers > 1)) {
+        printf("usage: %s queue <spsc|mpmc> <messages per producer> <message bytes (>= 8)> [producers] [slots]\n"
+               "       (spsc allows one producer)\n", argv[0]);
+        return 1;
+    }
+    key_t key = ftok("shmfile", 66);   // Not 65: the queue is a different segment from the demo's
+    if (key == -1) {
+        perror("ftok");
+        exit(1);
+    }
+    int shmid;
+    shmqueue *q = shmq_create(key, kind, slots, size, (uint64_t)messages * producers, producers, &shmid);
+    if (!q) {
+        perror("shmq_create");
+        exit(1);
+    }
+    printf("Queue ready: %s, %u slots of %d bytes; start ./10b queue to consume\n", kind ? "mpmc" : "spsc",
+           q->slots, size);
+    fflush(stdout);
+
+    double start = now_sec();
+    for (int p = 0; p < producers; p++) {
+        pid_t pid = producers > 1 ? fork() : 0; // Parent only forks when there are several producers
+        if (pid > 0) continue;
+        if (pid < 0) perror("fork (sending this producer's share from here instead)");
+        for (long i = 0; i < messages; i++) {
+            uint32_t pos;
+            uint64_t value = (uint64_t)p * messages + i;
+            char *msg = shmq_reserve(q, &pos); // Write straight into the slot
+            if (!msg) {
+                printf("The queue was replaced by another run; stopping\n");
+                exit(1);
+            }
+            memcpy(msg, &value, sizeof(value));
+            memset(msg + sizeof(value), (char)value, size - sizeof(value));
+            shmq_commit(q, pos, size);
+        }
+        shmq_done(q);
+        if (pid == 0 && producers > 1) exit(0);
+    }
+    while (producers > 1 && wait(NULL) > 0)
+        ;
+    double elapsed = now_sec() - start;
+    printf("Sent %ld messages of %d bytes in %.3f s: %.0f messages/s, %.1f MB/s\n", messages * producers, size,
+           elapsed, messages * producers / elapsed, messages * producers * (double)size / elapsed / 1e6);
+    shmdt(q);                          // 10b removes the segment when it has read everything
+    return 0;
+}
 // Possible Questions
 // What is the purpose of using shared memory?
 
@@ -13,8 +13,18 @@
 #include <sys/ipc.h>       // Include library for IPC (Inter-Process Communication) functions
 #include <sys/shm.h>       // Include library for shared memory functions
 #include <stdlib.h>        // Include standard library for memory allocation and process control
+#include <string.h>        // strcmp, for the queue mode
+#include <sys/wait.h>      // waitpid for the consumer processes in queue mode
+#include <sys/mman.h>      // Shared counters for the consumer processes
+#include <time.h>          // clock_gettime for the queue benchmark
+#include "shmqueue.h"      // Shared-memory message queue (queue mode)
+
+int queuemain(int argc, char *argv[]); // Message-stream mode, selected by command-line arguments
+
+int main(int argc, char *argv[]) {
+    if (argc > 1 && strcmp(argv[1], "queue") == 0)
+        return queuemain(argc, argv);  // Consume the message stream 10a is producing
 
-int main() {
     // Create the same key used by the server
     key_t key = ftok("shmfile", 65);  // Generate a unique key using the ftok function; "shmfile" is the pathname and 65 is a project identifier
     if (key == -1) {                   
@@ -53,6 +63,103 @@ int main() {
 
     return 0;                          // Return 0 to indicate successful completion of the program
 }
+
+double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// One consumer: read messages until every one has been claimed, or the queue goes
+// stale. st gets messages read, sum of their numbers, bad messages and the stale flag.
+void consume(shmqueue *q, long st[4]) {
+    long n = 0, sum = 0, bad = 0, stale = 0;
+    while (shmq_claim(q)) {            // One message is guaranteed to come for each claim
+        uint32_t pos, len;
+        const char *msg = shmq_peek(q, &pos, &len); // Read it where it lies
+        if (!msg) {                    // Replaced by a new run, or its producer died
+            stale = 1;
+            break;
+        }
+        uint64_t value;
+        memcpy(&value, msg, sizeof(value));
+        if (len != q->slotsize || msg[len - 1] != (char)value) bad++;
+        shmq_release(q, pos);
+        sum += value;
+        n++;
+    }
+    st[0] = n;
+    st[1] = sum;
+    st[2] = bad;
+    st[3] = stale;
+}
+
+// Queue mode: ./10b queue [consumers]. Attaches to the queue "./10a queue" created (waiting
+// for it if needed), reads every message in place, checks it, and removes the segment.
+// A segment left by an interrupted run is skipped, and if a new 10a replaces the queue
+// while we read it, we start over on the new one.
+int queuemain(int argc, char *argv[]) {
+    int wanted = argc > 2 ? atoi(argv[2]) : 1;
+    key_t key = ftok("shmfile", 66);   // Same key as 10a's queue mode
+    if (key == -1 || wanted < 1) {
+        if (key == -1) perror("ftok");
+        else printf("usage: %s queue [consumers]\n", argv[0]);
+        exit(1);
+    }
+    // Four counters per consumer (see consume), shared with the forked consumers
+    long *stats = mmap(NULL, 4 * wanted * sizeof(long), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (stats == MAP_FAILED) {
+        perror("mmap");
+        exit(1);
+    }
+    int shmid, consumers;
+    shmqueue *q;
+    long n, sum, bad, stale;
+    double elapsed;
+    while (1) {
+        while (!(q = shmq_attach(key, &shmid)) || shmq_stale(q)) { // 10a not started yet, or left over
+            if (q) shmdt(q);
+            usleep(10000);
+        }
+        consumers = wanted;
+        if (q->kind == SHMQ_SPSC && consumers > 1) {
+            printf("The queue is spsc: using one consumer\n");
+            consumers = 1;
+        }
+        double start = now_sec();
+        for (int c = 0; c < consumers; c++) {
+            pid_t pid = consumers > 1 ? fork() : 0;
+            if (pid > 0) continue;
+            if (pid < 0) perror("fork (reading this consumer's share from here instead)");
+            consume(q, stats + 4 * c);
+            if (pid == 0 && consumers > 1) exit(0);
+        }
+        while (consumers > 1 && wait(NULL) > 0)
+            ;
+        elapsed = now_sec() - start;
+        n = sum = bad = stale = 0;
+        for (int c = 0; c < consumers; c++) {
+            n += stats[4 * c];
+            sum += stats[4 * c + 1];
+            bad += stats[4 * c + 2];
+            stale |= stats[4 * c + 3];
+        }
+        if (!stale) break;
+        printf("The queue went stale after %ld messages (replaced, or its producer stopped); waiting for a new one\n",
+               n);
+        fflush(stdout);
+        shmdt(q);                      // Whoever replaces it removes it; leave it alone
+    }
+    long total = q->total;
+    printf("Received %ld messages of %u bytes in %.3f s: %.0f messages/s, %.1f MB/s, futex sleeps %lu%s\n", n,
+           q->slotsize, elapsed, n / elapsed, n * (double)q->slotsize / elapsed / 1e6,
+           (unsigned long)atomic_load(&q->sleeps),
+           bad || sum != total * (total - 1) / 2 ? "  CHECK FAILED" : "");
+    munmap(stats, 4 * wanted * sizeof(long));
+    shmdt(q);
+    shmctl(shmid, IPC_RMID, NULL);     // Done with the queue
+    return 0;
+}
 // Possible Questions for client.c
 // What is the purpose of ftok() in this code?
 
@@ -10,11 +10,19 @@
 #include <stdlib.h>            // Standard library for general functions like rand.
 #include <unistd.h>            // Provides access to the POSIX operating system API.
 #include <sys/types.h>         // Defines data types used in system calls.
+#include <stdatomic.h>          // Atomic ring indexes for the lock-free benchmark modes.
+#include <linux/futex.h>        // FUTEX_WAIT/FUTEX_WAKE for sleeping when a ring is empty or full.
+#include <limits.h>             // INT_MAX (wake every sleeper).
+#include <string.h>             // memcpy, strcmp.
+#include <time.h>               // clock_gettime for the benchmarks.
 
 #define BUFFER_SIZE 20         // Maximum size of the buffer for storing produced items.
 
 void *producer(void *arg);      // Function prototype for the producer thread.
 void *consumer(void *arg);      // Function prototype for the consumer thread.
+int benchmain(int argc, char *argv[]); // Benchmark modes, selected by command-line arguments.
+int layoutmain(int argc, char *argv[]);
+int pipelinemain(int argc, char *argv[]);
 
 typedef struct {
     int buffer[BUFFER_SIZE];    // Circular buffer for produced items.
@@ -26,7 +34,14 @@ shared_data sh;                 // Shared data structure instance to hold buffer
 
 sem_t mutex;                    // Mutex semaphore for critical section protection.
 
-int main() {
+int main(int argc, char *argv[]) {
+    if (argc > 1 && (strcmp(argv[1], "bench") == 0 || strcmp(argv[1], "scale") == 0))
+        return benchmain(argc, argv); // Non-interactive throughput benchmark.
+    if (argc > 1 && strcmp(argv[1], "layout") == 0)
+        return layoutmain(argc, argv); // Packed vs padded cursor benchmark.
+    if (argc > 1 && strcmp(argv[1], "pipeline") == 0)
+        return pipelinemain(argc, argv); // Multi-stage pipeline with per-stage thread pools.
+
     pthread_t ptid1, ptid2, ctid1; // Thread identifiers for producers and consumer.
     sh.in = 0;                     // Initialize the index for the next empty slot.
     sh.out = 0;                    // Initialize the index for the next filled slot.
@@ -83,6 +98,677 @@ void *consumer(void *arg) {
         sleep(2);                 // Simulate time taken to consume an item.
     }
 }
+
+// Benchmark modes (run with arguments; no arguments runs the demo above).
+// ringbuf is a bounded buffer with three interchangeable implementations:
+//   RING_SEM  - the scheme used by the demo: empty/full counting semaphores
+//               plus a binary semaphore around the copy. Every item still
+//               costs one wait and one post on the counting semaphores, even
+//               in a batch; with batch 1 this is the baseline.
+//   RING_SEMLOCK - semaphores used as a lock and wake-ups instead of counts:
+//               a binary semaphore guards the copy and the cursors (tail -
+//               head is the fill level), and empty/full only wake threads
+//               that found no slot or no item. A batch of any size costs one
+//               lock round and at most one wake-up post.
+//   RING_SPSC - one producer, one consumer: the producer owns tail, the
+//               consumer owns head, and each reads the other's index with
+//               acquire loads. No locks and no read-modify-write operations.
+//   RING_MPMC - Vyukov's bounded queue: every slot carries a sequence number
+//               that says whose turn it is, and producers/consumers claim
+//               positions with a compare-and-swap on tail/head.
+// The lock-free kinds spin briefly when the ring is full or empty and then
+// sleep on a futex, so a thread only enters the kernel when it has nothing to
+// do; the other side only makes the wake syscall if someone is sleeping.
+// The head and tail cursors can be packed into one cache line (as the demo's
+// in/out are) or padded onto lines of their own. Padded SPSC cursors also
+// keep a private copy of the opposite index and only re-read the real one
+// when the copy says the ring is full or empty, so in steady state each side
+// touches the other's cache line once per lap instead of once per item.
+
+#define RING_SEM 0
+#define RING_SPSC 1
+#define RING_MPMC 2
+#define RING_SEMLOCK 3
+#define SPIN_LIMIT 200          // Failed attempts before sleeping on the futex.
+#define CACHE_LINE 64
+
+typedef struct {
+    _Atomic unsigned pos;       // Next position to read (head) or write (tail).
+    unsigned cached;            // SPSC: owner's last-seen copy of the opposite cursor.
+} ringcursor;
+
+typedef struct {
+    _Atomic unsigned epoch;     // Futex word; bumped to wake sleepers.
+    _Atomic int waiters;        // Threads sleeping (or about to) on epoch.
+} waitpoint;
+
+typedef struct {
+    int kind;                   // RING_SEM, RING_SPSC, RING_MPMC or RING_SEMLOCK.
+    unsigned size, mask;        // Slot count (power of two) and size - 1.
+    size_t elemsize;            // Bytes per item.
+    char *slots;                // size * elemsize bytes of items.
+    _Atomic unsigned *seq;      // RING_MPMC: per-slot sequence numbers.
+    int padded;                 // Cursors on separate cache lines, with cached indexes.
+    ringcursor *head, *tail;    // Consumer and producer cursors (one allocation)...
+    waitpoint *notempty, *notfull; // ...together with the futex waitpoints.
+    sem_t full, empty, lock;    // RING_SEM and RING_SEMLOCK only.
+    int putwaiters, getwaiters; // RING_SEMLOCK: threads blocked on empty/full (under lock).
+    _Atomic long sleeps;        // Futex waits, for the report.
+} ringbuf;
+
+// Round n up to a whole number of cache lines (aligned_alloc needs it).
+size_t linesize(size_t n) {
+    return (n + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+}
+
+void ring_init(ringbuf *rb, int kind, unsigned size, size_t elemsize, int padded) {
+    unsigned i, s = 1;
+    while (s < size) s <<= 1;   // Round up to a power of two.
+    rb->kind = kind;
+    rb->size = s;
+    rb->mask = s - 1;
+    rb->elemsize = elemsize;
+    rb->padded = padded;
+    rb->slots = aligned_alloc(CACHE_LINE, linesize((size_t)s * elemsize));
+    rb->seq = aligned_alloc(CACHE_LINE, linesize(s * sizeof(_Atomic unsigned)));
+    for (i = 0; i < s; i++)
+        atomic_init(&rb->seq[i], i); // Slot i is free for position i.
+    // Packed: cursors and waitpoints side by side in one line. Padded: one
+    // line each, so a sleeper registering on notfull does not disturb the
+    // consumer's cursor and so on.
+    char *block = aligned_alloc(CACHE_LINE, padded ? 4 * CACHE_LINE : CACHE_LINE);
+    size_t step = padded ? CACHE_LINE : sizeof(ringcursor);
+    rb->head = (ringcursor *)block;
+    rb->tail = (ringcursor *)(block + step);
+    rb->notempty = (waitpoint *)(block + 2 * step);
+    rb->notfull = (waitpoint *)(block + 2 * step + (padded ? CACHE_LINE : sizeof(waitpoint)));
+    atomic_init(&rb->head->pos, 0);
+    atomic_init(&rb->tail->pos, 0);
+    rb->head->cached = rb->tail->cached = 0;
+    atomic_init(&rb->notempty->epoch, 0);
+    atomic_init(&rb->notempty->waiters, 0);
+    atomic_init(&rb->notfull->epoch, 0);
+    atomic_init(&rb->notfull->waiters, 0);
+    atomic_init(&rb->sleeps, 0);
+    sem_init(&rb->empty, 0, kind == RING_SEM ? s : 0); // RING_SEMLOCK counts waiters, not slots.
+    sem_init(&rb->full, 0, 0);
+    sem_init(&rb->lock, 0, 1);
+    rb->putwaiters = rb->getwaiters = 0;
+}
+
+void ring_destroy(ringbuf *rb) {
+    free(rb->slots);
+    free(rb->seq);
+    free(rb->head);
+    sem_destroy(&rb->empty);
+    sem_destroy(&rb->full);
+    sem_destroy(&rb->lock);
+}
+
+// Copy n items between buf and the slots starting at position pos, in at
+// most two pieces when the run wraps past the end of the ring.
+void ring_copy(ringbuf *rb, unsigned pos, void *buf, unsigned n, int in) {
+    unsigned at = pos & rb->mask, first = n < rb->size - at ? n : rb->size - at;
+    char *slot = rb->slots + (size_t)at * rb->elemsize, *b = buf;
+    if (in) {
+        memcpy(slot, b, first * rb->elemsize);
+        memcpy(rb->slots, b + first * rb->elemsize, (n - first) * rb->elemsize);
+    } else {
+        memcpy(b, slot, first * rb->elemsize);
+        memcpy(b + first * rb->elemsize, rb->slots, (n - first) * rb->elemsize);
+    }
+}
+
+// Non-blocking batch put: moves up to k items from items into the ring with
+// one publish (SPSC) or one compare-and-swap (MPMC). Returns how many were
+// put; 0 means the ring is full.
+unsigned ring_tryput_batch(ringbuf *rb, const void *items, unsigned k) {
+    unsigned pos = atomic_load_explicit(&rb->tail->pos, memory_order_relaxed), n, i;
+    if (rb->kind == RING_SPSC) {
+        unsigned head = rb->tail->cached;
+        if (!rb->padded || rb->size - (pos - head) < k) // Copy looks full: refresh it.
+            rb->tail->cached = head = atomic_load_explicit(&rb->head->pos, memory_order_acquire);
+        n = rb->size - (pos - head);
+        if (n > k) n = k;
+        if (n == 0) return 0;
+        ring_copy(rb, pos, (void *)items, n, 1);
+        atomic_store_explicit(&rb->tail->pos, pos + n, memory_order_release); // Publish all n.
+        return n;
+    }
+    while (1) { // RING_MPMC
+        // Count the free slots from pos on. They cannot be taken by anyone
+        // else until tail moves, so if the CAS succeeds they are all ours.
+        for (n = 0; n < k; n++) {
+            unsigned s = atomic_load_explicit(&rb->seq[(pos + n) & rb->mask], memory_order_acquire);
+            if (s != pos + n) break;
+        }
+        if (n == 0) {
+            unsigned s = atomic_load_explicit(&rb->seq[pos & rb->mask], memory_order_acquire);
+            if ((int)(s - pos) < 0) return 0; // Slot still holds an item from one lap ago: full.
+            pos = atomic_load_explicit(&rb->tail->pos, memory_order_relaxed); // Someone else took it.
+            continue;
+        }
+        if (atomic_compare_exchange_weak_explicit(&rb->tail->pos, &pos, pos + n, memory_order_relaxed,
+                                                  memory_order_relaxed))
+            break;
+    }
+    ring_copy(rb, pos, (void *)items, n, 1);
+    for (i = 0; i < n; i++) // Ready to read.
+        atomic_store_explicit(&rb->seq[(pos + i) & rb->mask], pos + i + 1, memory_order_release);
+    return n;
+}
+
+// Non-blocking batch get: drains up to k items into items. Returns how many
+// were taken; 0 means the ring is empty.
+unsigned ring_tryget_batch(ringbuf *rb, void *items, unsigned k) {
+    unsigned pos = atomic_load_explicit(&rb->head->pos, memory_order_relaxed), n, i;
+    if (rb->kind == RING_SPSC) {
+        unsigned tail = rb->head->cached;
+        if (!rb->padded || tail - pos < k) // Copy looks empty: refresh it.
+            rb->head->cached = tail = atomic_load_explicit(&rb->tail->pos, memory_order_acquire);
+        n = tail - pos;
+        if (n > k) n = k;
+        if (n == 0) return 0;
+        ring_copy(rb, pos, items, n, 0);
+        atomic_store_explicit(&rb->head->pos, pos + n, memory_order_release); // Free all n slots.
+        return n;
+    }
+    while (1) { // RING_MPMC
+        for (n = 0; n < k; n++) {
+            unsigned s = atomic_load_explicit(&rb->seq[(pos + n) & rb->mask], memory_order_acquire);
+            if (s != pos + n + 1) break;
+        }
+        if (n == 0) {
+            unsigned s = atomic_load_explicit(&rb->seq[pos & rb->mask], memory_order_acquire);
+            if ((int)(s - (pos + 1)) < 0) return 0; // Not written yet: empty.
+            pos = atomic_load_explicit(&rb->head->pos, memory_order_relaxed);
+            continue;
+        }
+        if (atomic_compare_exchange_weak_explicit(&rb->head->pos, &pos, pos + n, memory_order_relaxed,
+                                                  memory_order_relaxed))
+            break;
+    }
+    ring_copy(rb, pos, items, n, 0);
+    for (i = 0; i < n; i++) // Free for next lap.
+        atomic_store_explicit(&rb->seq[(pos + i) & rb->mask], pos + i + rb->mask + 1, memory_order_release);
+    return n;
+}
+
+// Non-blocking single-item put and get; return 0 if the ring is full/empty.
+int ring_tryput(ringbuf *rb, const void *item) {
+    return ring_tryput_batch(rb, item, 1);
+}
+
+int ring_tryget(ringbuf *rb, void *item) {
+    return ring_tryget_batch(rb, item, 1);
+}
+
+// Wake threads sleeping on wp, if there are any.
+void ring_wake(waitpoint *wp) {
+    atomic_thread_fence(memory_order_seq_cst); // Order our publish before reading waiters.
+    if (atomic_load_explicit(&wp->waiters, memory_order_relaxed) > 0) {
+        atomic_fetch_add(&wp->epoch, 1);
+        syscall(SYS_futex, &wp->epoch, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+    }
+}
+
+// Retry op until it moves at least one item: spin first, then sleep on wp
+// between attempts. Registering as a waiter before the last retry means a
+// wake cannot be missed. Returns the number of items moved.
+unsigned ring_wait(ringbuf *rb, waitpoint *wp, unsigned (*op)(ringbuf *, void *, unsigned), void *items,
+                   unsigned k) {
+    int spins = 0;
+    unsigned n;
+    while (!(n = op(rb, items, k))) {
+        if (++spins < SPIN_LIMIT) continue;
+        unsigned e = atomic_load(&wp->epoch);
+        atomic_fetch_add(&wp->waiters, 1);
+        if (!(n = op(rb, items, k))) {
+            atomic_fetch_add_explicit(&rb->sleeps, 1, memory_order_relaxed);
+            syscall(SYS_futex, &wp->epoch, FUTEX_WAIT_PRIVATE, e, NULL, NULL, 0);
+            atomic_fetch_sub(&wp->waiters, 1);
+            continue;
+        }
+        atomic_fetch_sub(&wp->waiters, 1);
+        break;
+    }
+    return n;
+}
+
+unsigned ring_tryput_cb(ringbuf *rb, void *items, unsigned k) {
+    return ring_tryput_batch(rb, items, k);
+}
+
+// RING_SEMLOCK: with rb->lock held, wait on sem until the ring has room
+// (put = 1) or items (put = 0), and return how many slots or items there
+// are. The lock is dropped while asleep. Whoever changes the fill level
+// posts sem once for one registered waiter (sem_wake).
+unsigned sem_await(ringbuf *rb, sem_t *sem, int *waiters, int put) {
+    unsigned fill;
+    while (1) {
+        fill = atomic_load_explicit(&rb->tail->pos, memory_order_relaxed) -
+               atomic_load_explicit(&rb->head->pos, memory_order_relaxed);
+        if (put ? fill < rb->size : fill > 0) return put ? rb->size - fill : fill;
+        (*waiters)++;
+        sem_post(&rb->lock);
+        sem_wait(sem);
+        sem_wait(&rb->lock);
+    }
+}
+
+// RING_SEMLOCK, lock held: wake one thread waiting on sem, if any.
+void sem_wake(sem_t *sem, int *waiters) {
+    if (*waiters > 0) {
+        (*waiters)--;
+        sem_post(sem);
+    }
+}
+
+// Blocking batch put: returns once all k items are in the ring. Each round
+// puts as many as currently fit. RING_SEMLOCK takes all the free slots it
+// can use in one lock round, then wakes a consumer and, if slots are left,
+// the next waiting producer.
+void ring_put_batch(ringbuf *rb, const void *items, unsigned k) {
+    const char *b = items;
+    while (k > 0) {
+        unsigned n = 1, i;
+        if (rb->kind == RING_SEM) {
+            sem_wait(&rb->empty);
+            while (n < k && sem_trywait(&rb->empty) == 0) n++;
+            sem_wait(&rb->lock);
+            unsigned pos = atomic_load_explicit(&rb->tail->pos, memory_order_relaxed);
+            ring_copy(rb, pos, (void *)b, n, 1);
+            atomic_store_explicit(&rb->tail->pos, pos + n, memory_order_relaxed);
+            sem_post(&rb->lock);
+            for (i = 0; i < n; i++) sem_post(&rb->full);
+        } else if (rb->kind == RING_SEMLOCK) {
+            sem_wait(&rb->lock);
+            n = sem_await(rb, &rb->empty, &rb->putwaiters, 1);
+            int left = n > k;
+            if (n > k) n = k;
+            unsigned pos = atomic_load_explicit(&rb->tail->pos, memory_order_relaxed);
+            ring_copy(rb, pos, (void *)b, n, 1);
+            atomic_store_explicit(&rb->tail->pos, pos + n, memory_order_relaxed);
+            sem_wake(&rb->full, &rb->getwaiters);
+            if (left) sem_wake(&rb->empty, &rb->putwaiters);
+            sem_post(&rb->lock);
+        } else {
+            n = ring_wait(rb, rb->notfull, ring_tryput_cb, (void *)b, k);
+            ring_wake(rb->notempty);
+        }
+        b += (size_t)n * rb->elemsize;
+        k -= n;
+    }
+}
+
+// Blocking batch get: waits for at least one item, then drains up to k.
+// Returns how many items were stored in items.
+unsigned ring_get_batch(ringbuf *rb, void *items, unsigned k) {
+    unsigned n = 1, i;
+    if (rb->kind == RING_SEM) {
+        sem_wait(&rb->full);
+        while (n < k && sem_trywait(&rb->full) == 0) n++;
+        sem_wait(&rb->lock);
+        unsigned pos = atomic_load_explicit(&rb->head->pos, memory_order_relaxed);
+        ring_copy(rb, pos, items, n, 0);
+        atomic_store_explicit(&rb->head->pos, pos + n, memory_order_relaxed);
+        sem_post(&rb->lock);
+        for (i = 0; i < n; i++) sem_post(&rb->empty);
+        return n;
+    }
+    if (rb->kind == RING_SEMLOCK) {
+        sem_wait(&rb->lock);
+        n = sem_await(rb, &rb->full, &rb->getwaiters, 0);
+        int left = n > k;
+        if (n > k) n = k;
+        unsigned pos = atomic_load_explicit(&rb->head->pos, memory_order_relaxed);
+        ring_copy(rb, pos, items, n, 0);
+        atomic_store_explicit(&rb->head->pos, pos + n, memory_order_relaxed);
+        sem_wake(&rb->empty, &rb->putwaiters);
+        if (left) sem_wake(&rb->full, &rb->getwaiters);
+        sem_post(&rb->lock);
+        return n;
+    }
+    n = ring_wait(rb, rb->notempty, ring_tryget_batch, items, k);
+    ring_wake(rb->notfull);
+    return n;
+}
+
+// Blocking single-item put and get.
+void ring_put(ringbuf *rb, const void *item) {
+    ring_put_batch(rb, item, 1);
+}
+
+void ring_get(ringbuf *rb, void *item) {
+    ring_get_batch(rb, item, 1);
+}
+
+const char *ringname[] = {"sem", "spsc", "mpmc", "semlock"};
+
+// Every benchmark item starts with this header; the rest is payload bytes.
+typedef struct {
+    long seq;                   // Producer's item number (checked by the consumers).
+    long stamp;                 // Enqueue time in ns, for the latency histogram.
+} itemheader;
+
+#define HIST_BUCKETS 40         // Bucket b counts latencies in [2^b, 2^(b+1)) ns.
+
+typedef struct {
+    ringbuf *rb;
+    long count;                 // Items this thread moves.
+    unsigned batch;             // Items per ring_put_batch/ring_get_batch call.
+    long sum;                   // Consumer: checksum of the items it read.
+    long hist[HIST_BUCKETS];    // Consumer: enqueue-to-dequeue latency histogram.
+} benchthread;
+
+long now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+double now_sec() {
+    return now_ns() / 1e9;
+}
+
+void *benchproducer(void *arg) {
+    benchthread *t = arg;
+    size_t es = t->rb->elemsize;
+    char *items = calloc(t->batch, es);
+    for (long i = 0; i < t->count;) {
+        unsigned n = t->count - i < t->batch ? t->count - i : t->batch, j;
+        long stamp = now_ns();
+        for (j = 0; j < n; j++, i++) {
+            itemheader *h = (itemheader *)(items + j * es);
+            h->seq = i;
+            h->stamp = stamp;
+        }
+        ring_put_batch(t->rb, items, n);
+    }
+    free(items);
+    return NULL;
+}
+
+void *benchconsumer(void *arg) {
+    benchthread *t = arg;
+    size_t es = t->rb->elemsize;
+    char *items = malloc(t->batch * es);
+    for (long i = 0; i < t->count;) {
+        unsigned want = t->count - i < t->batch ? t->count - i : t->batch;
+        unsigned n = ring_get_batch(t->rb, items, want), j;
+        long now = now_ns();
+        for (j = 0; j < n; j++, i++) {
+            itemheader *h = (itemheader *)(items + j * es);
+            long lat = now - h->stamp;
+            int b = 0;
+            while (b < HIST_BUCKETS - 1 && lat >= 2L << b) b++; // log2 bucket
+            t->hist[b]++;
+            t->sum += h->seq;
+        }
+    }
+    free(items);
+    return NULL;
+}
+
+// Upper edge (ns) of the bucket holding the p-th percentile.
+long histpercentile(long hist[], long total, double pct) {
+    long seen = 0, want = (long)(total * pct / 100.0);
+    for (int b = 0; b < HIST_BUCKETS; b++) {
+        seen += hist[b];
+        if (seen > want) return 2L << b;
+    }
+    return 2L << (HIST_BUCKETS - 1);
+}
+
+// Move items through a ring of the given kind and cursor layout, batch items
+// per call; returns items/sec. report 0 prints nothing, 1 a summary line and
+// 2 the latency histogram as well.
+double runbench(int kind, int padded, int producers, int consumers, long items, unsigned bufsize,
+                size_t payload, unsigned batch, int report) {
+    ringbuf rb;
+    pthread_t tid[producers + consumers];
+    benchthread *t = calloc(producers + consumers, sizeof(benchthread));
+    long sum = 0, expect = 0, hist[HIST_BUCKETS] = {0};
+    int i, b;
+    ring_init(&rb, kind, bufsize, sizeof(itemheader) + payload, padded);
+    for (i = 0; i < producers + consumers; i++) {
+        int c = i >= producers, k = c ? i - producers : i, of = c ? consumers : producers;
+        t[i].rb = &rb;
+        t[i].batch = batch;
+        t[i].count = items / of + (k < items % of); // Split items evenly.
+        if (!c) expect += t[i].count * (t[i].count - 1) / 2;
+    }
+    double start = now_sec();
+    for (i = 0; i < producers + consumers; i++)
+        pthread_create(&tid[i], NULL, i < producers ? benchproducer : benchconsumer, &t[i]);
+    for (i = 0; i < producers + consumers; i++)
+        pthread_join(tid[i], NULL);
+    double elapsed = now_sec() - start;
+    for (i = producers; i < producers + consumers; i++) {
+        sum += t[i].sum;
+        for (b = 0; b < HIST_BUCKETS; b++)
+            hist[b] += t[i].hist[b];
+    }
+    if (report > 0) {
+        printf("%-7s %-6s %2dP/%dC  batch %u  %ld items of %zu bytes in %.3f s  %.0f items/sec  p50 %ld ns  p99 %ld ns"
+               "  p999 %ld ns",
+               ringname[kind], padded ? "padded" : "packed", producers, consumers, batch, items, rb.elemsize,
+               elapsed, items / elapsed,
+               histpercentile(hist, items, 50), histpercentile(hist, items, 99), histpercentile(hist, items, 99.9));
+        if (kind == RING_SPSC || kind == RING_MPMC)
+            printf("  futex sleeps %ld", atomic_load(&rb.sleeps));
+        printf("%s\n", sum == expect ? "" : "  CHECKSUM MISMATCH");
+        if (report > 1) {
+            printf("  latency        items\n");
+            for (b = 0; b < HIST_BUCKETS; b++)
+                if (hist[b]) printf("  < %9ld ns  %ld\n", 2L << b, hist[b]);
+        }
+    } else if (sum != expect) {
+        printf("%s %dP/%dC  CHECKSUM MISMATCH\n", ringname[kind], producers, consumers);
+    }
+    ring_destroy(&rb);
+    free(t);
+    return items / elapsed;
+}
+
+// ./a.out layout <items> <buffer size> <max threads>
+// Packed vs padded cursors: spsc with one producer and consumer, mpmc with
+// 1, 2, 4, ... of each up to max threads.
+int layoutmain(int argc, char *argv[]) {
+    long items = argc > 2 ? atol(argv[2]) : 1000000;
+    int bufsize = argc > 3 ? atoi(argv[3]) : 1024, maxthreads = argc > 4 ? atoi(argv[4]) : 8, n;
+    if (items < 1 || bufsize < 1 || maxthreads < 1) {
+        printf("usage: %s layout <items> <buffer size> <max threads>\n", argv[0]);
+        return 1;
+    }
+    printf("%-5s %5s %15s %15s %8s\n", "ring", "P/C", "packed/sec", "padded/sec", "speedup");
+    for (n = 0; n <= maxthreads; n = n ? n * 2 : 1) {
+        int kind = n ? RING_MPMC : RING_SPSC, threads = n ? n : 1;
+        double packed = runbench(kind, 0, threads, threads, items, bufsize, 0, 1, 0);
+        double padded = runbench(kind, 1, threads, threads, items, bufsize, 0, 1, 0);
+        printf("%-5s %2d/%-2d %15.0f %15.0f %7.2fx\n", ringname[kind], threads, threads, packed, padded,
+               padded / packed);
+    }
+    return 0;
+}
+
+// ./a.out bench <sem|spsc|mpmc|semlock|all> <producers> <consumers> <items> <buffer size> [payload bytes] [batch]
+// ./a.out scale <sem|spsc|mpmc|semlock|all> <items> <buffer size> <payload bytes> <max threads> [batch]
+int benchmain(int argc, char *argv[]) {
+    int scale = strcmp(argv[1], "scale") == 0, k, n;
+    const char *mode = argc > 2 ? argv[2] : "all";
+    int producers = !scale && argc > 3 ? atoi(argv[3]) : 1, consumers = !scale && argc > 4 ? atoi(argv[4]) : 1;
+    long items = argc > (scale ? 3 : 5) ? atol(argv[scale ? 3 : 5]) : 1000000;
+    int bufsize = argc > (scale ? 4 : 6) ? atoi(argv[scale ? 4 : 6]) : BUFFER_SIZE;
+    int payload = argc > (scale ? 5 : 7) ? atoi(argv[scale ? 5 : 7]) : 0;
+    int maxthreads = scale && argc > 6 ? atoi(argv[6]) : 16;
+    int batch = argc > (scale ? 7 : 8) ? atoi(argv[scale ? 7 : 8]) : 1;
+    if (producers < 1 || consumers < 1 || items < 1 || bufsize < 1 || payload < 0 || maxthreads < 1 || batch < 1) {
+        printf("usage: %s bench <sem|spsc|mpmc|semlock|all> <producers> <consumers> <items> <buffer size> [payload bytes]"
+               " [batch]\n"
+               "       %s scale <sem|spsc|mpmc|semlock|all> <items> <buffer size> <payload bytes> <max threads> [batch]\n",
+               argv[0], argv[0]);
+        return 1;
+    }
+    for (k = RING_SEM; k <= RING_SEMLOCK; k++) {
+        if (strcmp(mode, "all") != 0 && strcmp(mode, ringname[k]) != 0) continue;
+        if (!scale) {
+            if (k == RING_SPSC && (producers > 1 || consumers > 1)) {
+                printf("spsc  skipped: needs exactly one producer and one consumer\n");
+                continue;
+            }
+            runbench(k, 1, producers, consumers, items, bufsize, payload, batch, 2);
+            continue;
+        }
+        // Double producers and consumers until throughput stops growing by 5%.
+        double best = 0, rate;
+        for (n = 1; n <= maxthreads; n *= 2) {
+            if (k == RING_SPSC && n > 1) break;
+            rate = runbench(k, 1, n, n, items, bufsize, payload, batch, 1);
+            if (rate < best * 1.05) {
+                printf("%-7s saturated at about %.0f items/sec\n", ringname[k], best > rate ? best : rate);
+                break;
+            }
+            best = rate;
+        }
+    }
+    return 0;
+}
+
+// Pipeline mode: a chain of stages joined by rings, each stage with its own
+// pool of threads. The first stage generates items, the last one consumes
+// them, and every stage spins for a configurable time per item to stand in
+// for real work (parse, transform, write...). A full ring blocks the stage in
+// front of it, so a slow stage pushes back on everything upstream. Each stage
+// reports its throughput, how its threads spent their time (working, waiting
+// for input, waiting for space downstream) and how full its input ring was.
+#define MAX_STAGES 8
+
+typedef struct {
+    char name[16];
+    int threads;
+    long workns;                // Simulated work per item.
+    ringbuf *in, *out;          // No input for the first stage, no output for the last.
+    int outthreads;             // Threads of the next stage (one end marker each).
+    long total;                 // First stage: items to generate.
+    _Atomic long next;          // First stage: next sequence number to hand out.
+    _Atomic int running;        // Threads still running; the last one forwards the end.
+    _Atomic long items, busyns, getwaitns, putwaitns, depthsum, depthsamples, sum;
+} pipestage;
+
+void *stageworker(void *arg) {
+    pipestage *st = arg;
+    itemheader item;
+    long items = 0, busy = 0, getwait = 0, putwait = 0, depthsum = 0, samples = 0, sum = 0, t0, t1;
+    int i;
+    while (1) {
+        if (st->in) {
+            t0 = now_ns();
+            ring_get(st->in, &item);
+            t1 = now_ns();
+            getwait += t1 - t0;
+            if (item.seq < 0) break; // End of stream.
+            if ((items & 15) == 0) { // Sample the input depth every 16 items.
+                depthsum += atomic_load_explicit(&st->in->tail->pos, memory_order_relaxed) -
+                            atomic_load_explicit(&st->in->head->pos, memory_order_relaxed);
+                samples++;
+            }
+        } else {
+            item.seq = atomic_fetch_add_explicit(&st->next, 1, memory_order_relaxed);
+            if (item.seq >= st->total) break;
+            t1 = item.stamp = now_ns();
+        }
+        while ((t0 = now_ns()) - t1 < st->workns)
+            ; // The stage's work.
+        busy += t0 - t1;
+        items++;
+        if (st->out) {
+            ring_put(st->out, &item);
+            putwait += now_ns() - t0;
+        } else {
+            sum += item.seq;
+        }
+    }
+    atomic_fetch_add(&st->items, items);
+    atomic_fetch_add(&st->busyns, busy);
+    atomic_fetch_add(&st->getwaitns, getwait);
+    atomic_fetch_add(&st->putwaitns, putwait);
+    atomic_fetch_add(&st->depthsum, depthsum);
+    atomic_fetch_add(&st->depthsamples, samples);
+    atomic_fetch_add(&st->sum, sum);
+    if (atomic_fetch_sub(&st->running, 1) == 1 && st->out) {
+        item.seq = -1; // Last thread out: tell every thread of the next stage.
+        for (i = 0; i < st->outthreads; i++)
+            ring_put(st->out, &item);
+    }
+    return NULL;
+}
+
+// ./a.out pipeline <items> <buffer size> <name:threads:work ns>...
+int pipelinemain(int argc, char *argv[]) {
+    pipestage st[MAX_STAGES];
+    ringbuf rings[MAX_STAGES - 1];
+    char *defaults[] = {"parse:1:200", "transform:2:800", "write:1:300"};
+    char **spec = argc > 4 ? argv + 4 : defaults;
+    int nstages = argc > 4 ? argc - 4 : 3, i, j, bottleneck = 0;
+    long items = argc > 2 ? atol(argv[2]) : 1000000;
+    int bufsize = argc > 3 ? atoi(argv[3]) : 256;
+    if (items < 1 || bufsize < 1 || nstages < 2 || nstages > MAX_STAGES) {
+        printf("usage: %s pipeline <items> <buffer size> <name:threads:work ns>... (2 to %d stages)\n", argv[0],
+               MAX_STAGES);
+        return 1;
+    }
+    memset(st, 0, sizeof(st));
+    for (i = 0; i < nstages; i++) {
+        if (sscanf(spec[i], "%15[^:]:%d:%ld", st[i].name, &st[i].threads, &st[i].workns) != 3 ||
+            st[i].threads < 1 || st[i].workns < 0) {
+            printf("bad stage '%s': expected name:threads:work ns\n", spec[i]);
+            return 1;
+        }
+    }
+    for (i = 0; i < nstages; i++) {
+        if (i + 1 < nstages) { // SPSC is enough between two single-threaded stages.
+            int spsc = st[i].threads == 1 && st[i + 1].threads == 1;
+            ring_init(&rings[i], spsc ? RING_SPSC : RING_MPMC, bufsize, sizeof(itemheader), 1);
+            st[i].out = st[i + 1].in = &rings[i];
+            st[i].outthreads = st[i + 1].threads;
+        }
+        st[i].total = items;
+        atomic_init(&st[i].running, st[i].threads);
+    }
+    int nthreads = 0;
+    for (i = 0; i < nstages; i++) nthreads += st[i].threads;
+    pthread_t tid[nthreads];
+    double start = now_sec();
+    for (i = 0, nthreads = 0; i < nstages; i++)
+        for (j = 0; j < st[i].threads; j++)
+            pthread_create(&tid[nthreads++], NULL, stageworker, &st[i]);
+    for (i = 0; i < nthreads; i++)
+        pthread_join(tid[i], NULL);
+    double elapsed = now_sec() - start;
+
+    printf("%ld items through %d stages in %.3f s (%.0f items/sec)%s\n", items, nstages, elapsed, items / elapsed,
+           atomic_load(&st[nstages - 1].sum) == items * (items - 1) / 2 ? "" : "  CHECKSUM MISMATCH");
+    printf("%-12s %7s %13s %7s %8s %8s %14s\n", "stage", "threads", "items/sec", "busy%", "starved%", "blocked%",
+           "input depth");
+    for (i = 0; i < nstages; i++) {
+        double threadns = elapsed * 1e9 * st[i].threads, busy = 100 * st[i].busyns / threadns;
+        long samples = atomic_load(&st[i].depthsamples);
+        printf("%-12s %7d %13.0f %6.1f%% %7.1f%% %7.1f%% ", st[i].name, st[i].threads,
+               atomic_load(&st[i].items) / elapsed, busy, 100 * st[i].getwaitns / threadns,
+               100 * st[i].putwaitns / threadns);
+        if (st[i].in)
+            printf("%7.1f/%-6u\n", samples ? (double)st[i].depthsum / samples : 0.0, st[i].in->size);
+        else
+            printf("%14s\n", "-");
+        if (busy > 100 * st[bottleneck].busyns / (elapsed * 1e9 * st[bottleneck].threads)) bottleneck = i;
+    }
+    printf("bottleneck: %s (its threads are busiest; stages before it back up)\n", st[bottleneck].name);
+    for (i = 0; i + 1 < nstages; i++)
+        ring_destroy(&rings[i]);
+    return 0;
+}
+
 /*
 Explanation of Specific Keywords and Libraries
 
@@ -3,14 +3,23 @@
 
 // Line-by-Line Explanation and Code Comments
 
+#define _GNU_SOURCE             // sched_getcpu for the per-CPU reader slots.
 #include <stdio.h>              // Standard I/O library for printf and scanf functions.
 #include <unistd.h>             // Provides access to the POSIX operating system API.
-#include <semaphore.h>          // Library for semaphore functions (not used in this code).
+#include <semaphore.h>          // Library for semaphore functions (used by the benchmark locks).
 #include <pthread.h>            // Library for working with threads (pthread functions).
 #include <sys/syscall.h>        // Provides access to system calls, such as getpid.
+#include <stdlib.h>             // calloc, atoi for the benchmark.
+#include <string.h>             // strcmp.
+#include <stdatomic.h>          // Atomic ticket counters and shared words for the benchmark.
+#include <sched.h>              // sched_yield while spinning.
+#include <time.h>               // clock_gettime, nanosleep.
 
 void *reader(void *argp);      // Function prototype for the reader thread.
 void *writer(void *argp);      // Function prototype for the writer thread.
+int benchmain(int argc, char *argv[]); // Lock benchmark, selected by command-line arguments.
+int scalemain(int argc, char *argv[]);
+int loadmain(int argc, char *argv[]);
 int buffer;                    // Shared buffer to hold the data.
 int flag = 0;                  // Flag to indicate if the buffer is filled.
 int read_count = 0;            // Count of active readers.
@@ -30,7 +39,14 @@ void readbuff(int buffer) {     // Function to read the buffer and display its c
 pthread_mutex_t mutex1 = PTHREAD_MUTEX_INITIALIZER; // Mutex for reader access.
 pthread_mutex_t wrt = PTHREAD_MUTEX_INITIALIZER;     // Mutex for writer access.
 
-int main() {
+int main(int argc, char *argv[]) {
+    if (argc > 1 && strcmp(argv[1], "bench") == 0)
+        return benchmain(argc, argv); // Non-interactive reader-writer lock benchmark.
+    if (argc > 1 && strcmp(argv[1], "scale") == 0)
+        return scalemain(argc, argv); // Read-side scaling with 1, 2, 4, ... readers.
+    if (argc > 1 && strcmp(argv[1], "load") == 0)
+        return loadmain(argc, argv); // Fixed-work load generator with hold/wait histograms.
+
     pthread_t wtid1, rtid1, rtid2; // Thread identifiers for writer and readers.
     pthread_create(&wtid1, NULL, writer, NULL); // Create writer thread.
     pthread_create(&rtid1, NULL, reader, NULL); // Create first reader thread.
@@ -46,12 +62,18 @@ int main() {
 // Writer thread function
 void* writer(void *argp) {
     while (1) {                // Infinite loop for continuous writing.
-        pthread_mutex_lock(&wrt); // Lock the writer mutex.
-        if (flag == 0) {        // Check if the buffer is empty.
-            buffer = getbuff(); // Get input from the user to fill the buffer.
-            flag = 1;          // Set the flag to indicate that the buffer is filled.
+        int item = getbuff(); // Get input from the user before locking, so readers are not held up by scanf.
+        int stored = 0;
+        while (!stored) {      // Retry until the readers have emptied the buffer.
+            pthread_mutex_lock(&wrt); // Lock the writer mutex.
+            if (flag == 0) {    // Check if the buffer is empty.
+                buffer = item;  // Fill the buffer with the value entered.
+                flag = 1;      // Set the flag to indicate that the buffer is filled.
+                stored = 1;
+            }
+            pthread_mutex_unlock(&wrt); // Unlock the writer mutex.
+            if (!stored) sched_yield(); // Let a reader in before trying again.
         }
-        pthread_mutex_unlock(&wrt); // Unlock the writer mutex.
     }
 }
 
@@ -66,10 +88,11 @@ void* reader(void *argp) {
         }
         pthread_mutex_unlock(&mutex1); // Unlock the reader access mutex.
 
+        int item = 0, got = 0;
         if (flag == 1) {      // Check if the buffer is filled.
-            readbuff(buffer); // Read the buffer and display the content.
-            sleep(1);         // Simulate time taken to read.
+            item = buffer;    // Only copy the value while holding the lock.
             flag = 0;        // Reset the flag to indicate that the buffer has been read.
+            got = 1;
         }
 
         pthread_mutex_lock(&mutex1); // Lock the mutex for reader access.
@@ -79,8 +102,606 @@ void* reader(void *argp) {
             pthread_mutex_unlock(&wrt); // Unlock the writer mutex to allow writing.
         }
         pthread_mutex_unlock(&mutex1); // Unlock the reader access mutex.
+
+        if (got) {
+            readbuff(item);   // Display the content outside the read section.
+            sleep(1);         // Simulate time taken to process what was read.
+        }
+    }
+}
+
+// Benchmark mode (run with arguments; no arguments runs the demo above).
+// rwlock wraps several reader-writer lock designs behind one interface:
+//   RW_READPREF  - the demo's scheme: read_count guarded by a mutex, and the
+//                  first reader in / last reader out holds wrt. A steady
+//                  stream of readers can starve writers forever.
+//   RW_WRITEPREF - a mutex and two condition variables; new readers wait
+//                  while any writer is waiting, so writers cannot starve
+//                  (but readers can).
+//   RW_PHASEFAIR - Brandenburg and Anderson's phase-fair ticket lock: read
+//                  and write phases alternate, writers are served in ticket
+//                  order and a reader waits for at most one writer.
+//   RW_BIGREADER - a per-CPU ("big-reader") lock: each reader only bumps the
+//                  counter of the CPU it runs on, each on its own cache
+//                  line, so readers on different CPUs share nothing. A
+//                  writer raises a flag and waits for every slot to drain.
+// Two more modes are not locks for readers at all:
+//   RW_SEQLOCK   - writers (serialized by a mutex) make a sequence number
+//                  odd while they write and even again after. Readers copy
+//                  the data and retry if the number was odd or changed;
+//                  they never write shared memory.
+//   RW_RCU       - the data lives in a snapshot that writers replace
+//                  through an atomic pointer. Readers load the pointer and
+//                  copy, without waiting or retrying. Each reader posts the
+//                  epoch it entered in; a writer bumps the epoch after the
+//                  swap and frees the old snapshot once no reader is still
+//                  in an older epoch.
+// The benchmark readers copy a block of words that every writer overwrites
+// with one value, so a torn read (mixed values) means the lock is broken.
+
+#define RW_READPREF 0
+#define RW_WRITEPREF 1
+#define RW_PHASEFAIR 2
+#define RW_BIGREADER 3
+#define RW_SEQLOCK 4
+#define RW_RCU 5
+#define RW_KINDS 6
+#define RW_SLOTS 64             // RW_BIGREADER slots (CPU number modulo this); RW_RCU: one per reader.
+#define CACHE_LINE 64
+#define DATA_WORDS 16           // Words in the benchmark's shared block.
+#define SPIN_LIMIT 100          // Busy-wait rounds before yielding the CPU.
+
+// Phase-fair lock word layout: readers count in units of RINC in rin/rout;
+// the low bits of rin say whether a writer is present and its phase.
+#define PF_RINC 0x100
+#define PF_WBITS 0x3
+#define PF_PRES 0x2
+#define PF_PHID 0x1
+
+typedef struct {
+    _Alignas(CACHE_LINE) _Atomic int readers; // Bigreader: readers inside that entered on this CPU.
+                                              // RCU: epoch this reader entered in, 0 when outside.
+} readerslot;
+
+typedef struct {
+    int words[DATA_WORDS];
+} snapshot;                     // RW_RCU: one published version of the shared data.
+
+typedef struct {
+    int kind;
+    pthread_mutex_t countlock;  // RW_READPREF: protects readcount.
+    sem_t wrt;                  // RW_READPREF: held by a writer or by the readers as a group.
+    int readcount;
+    pthread_mutex_t m;          // RW_WRITEPREF: protects the fields below.
+    pthread_cond_t readok, writeok;
+    int readers, writing, waitingwriters;
+    _Atomic unsigned rin, rout, win, wout; // RW_PHASEFAIR tickets.
+    readerslot *slots;          // RW_BIGREADER: RW_SLOTS padded counters.
+    _Atomic int writer;         // RW_BIGREADER: a writer holds or wants the lock.
+    pthread_mutex_t writerlock; // RW_BIGREADER, RW_SEQLOCK, RW_RCU: one writer at a time.
+    _Atomic unsigned seq;       // RW_SEQLOCK: odd while a write is in progress.
+    _Atomic(snapshot *) current; // RW_RCU: the version readers see.
+    _Atomic int epoch;          // RW_RCU: bumped after every swap.
+} rwlock;
+
+const char *rwname[] = {"readpref", "writepref", "phasefair", "bigreader", "seqlock", "rcu"};
+
+void rw_init(rwlock *l, int kind) {
+    l->kind = kind;
+    pthread_mutex_init(&l->countlock, NULL);
+    sem_init(&l->wrt, 0, 1);    // A semaphore: the reader that releases it may not be the one that took it.
+    l->readcount = 0;
+    pthread_mutex_init(&l->m, NULL);
+    pthread_cond_init(&l->readok, NULL);
+    pthread_cond_init(&l->writeok, NULL);
+    l->readers = l->writing = l->waitingwriters = 0;
+    atomic_init(&l->rin, 0);
+    atomic_init(&l->rout, 0);
+    atomic_init(&l->win, 0);
+    atomic_init(&l->wout, 0);
+    l->slots = aligned_alloc(CACHE_LINE, RW_SLOTS * sizeof(readerslot));
+    for (int i = 0; i < RW_SLOTS; i++)
+        atomic_init(&l->slots[i].readers, 0);
+    atomic_init(&l->writer, 0);
+    pthread_mutex_init(&l->writerlock, NULL);
+    atomic_init(&l->seq, 0);
+    atomic_init(&l->current, calloc(1, sizeof(snapshot)));
+    atomic_init(&l->epoch, 1);
+}
+
+void rw_destroy(rwlock *l) {
+    pthread_mutex_destroy(&l->countlock);
+    sem_destroy(&l->wrt);
+    pthread_mutex_destroy(&l->m);
+    pthread_cond_destroy(&l->readok);
+    pthread_cond_destroy(&l->writeok);
+    free(l->slots);
+    pthread_mutex_destroy(&l->writerlock);
+    free(atomic_load(&l->current));
+}
+
+// Called in busy-wait loops: spin a while, then give the CPU away.
+void relax(int *spins) {
+    if (++*spins >= SPIN_LIMIT) {
+        *spins = 0;
+        sched_yield();
+    }
+}
+
+// Acquire for reading. The returned token must be passed to rw_rdunlock().
+int rw_rdlock(rwlock *l) {
+    int spins = 0;
+    switch (l->kind) {
+    case RW_READPREF:
+        pthread_mutex_lock(&l->countlock);
+        if (++l->readcount == 1) sem_wait(&l->wrt); // First reader locks out writers.
+        pthread_mutex_unlock(&l->countlock);
+        break;
+    case RW_WRITEPREF:
+        pthread_mutex_lock(&l->m);
+        while (l->writing || l->waitingwriters > 0) pthread_cond_wait(&l->readok, &l->m);
+        l->readers++;
+        pthread_mutex_unlock(&l->m);
+        break;
+    case RW_PHASEFAIR: {
+        unsigned w = atomic_fetch_add(&l->rin, PF_RINC) & PF_WBITS;
+        // A writer is present: wait for its phase to end (the bits change).
+        while (w != 0 && w == (atomic_load(&l->rin) & PF_WBITS)) relax(&spins);
+        break;
+    }
+    case RW_BIGREADER: {
+        // The thread may migrate before unlocking, so the slot is returned
+        // as the token rather than looked up again. sched_getcpu can fail
+        // (-1); such a thread spreads by its thread id instead.
+        int cpu = sched_getcpu();
+        int slot = (cpu >= 0 ? cpu : (int)syscall(SYS_gettid)) % RW_SLOTS;
+        while (1) {
+            atomic_fetch_add(&l->slots[slot].readers, 1); // Announce, then check for a writer.
+            if (!atomic_load(&l->writer)) return slot;
+            atomic_fetch_sub(&l->slots[slot].readers, 1); // Back off so the writer can drain.
+            while (atomic_load_explicit(&l->writer, memory_order_relaxed)) relax(&spins);
+        }
+    }
+    }
+    return 0;
+}
+
+void rw_rdunlock(rwlock *l, int token) {
+    switch (l->kind) {
+    case RW_READPREF:
+        pthread_mutex_lock(&l->countlock);
+        if (--l->readcount == 0) sem_post(&l->wrt); // Last reader lets writers in.
+        pthread_mutex_unlock(&l->countlock);
+        break;
+    case RW_WRITEPREF:
+        pthread_mutex_lock(&l->m);
+        if (--l->readers == 0 && l->waitingwriters > 0) pthread_cond_signal(&l->writeok);
+        pthread_mutex_unlock(&l->m);
+        break;
+    case RW_PHASEFAIR:
+        atomic_fetch_add(&l->rout, PF_RINC);
+        break;
+    case RW_BIGREADER:
+        atomic_fetch_sub_explicit(&l->slots[token].readers, 1, memory_order_release);
+        break;
+    }
+}
+
+void rw_wrlock(rwlock *l) {
+    int spins = 0;
+    switch (l->kind) {
+    case RW_READPREF:
+        sem_wait(&l->wrt);
+        break;
+    case RW_WRITEPREF:
+        pthread_mutex_lock(&l->m);
+        l->waitingwriters++;
+        while (l->writing || l->readers > 0) pthread_cond_wait(&l->writeok, &l->m);
+        l->waitingwriters--;
+        l->writing = 1;
+        pthread_mutex_unlock(&l->m);
+        break;
+    case RW_PHASEFAIR: {
+        unsigned ticket = atomic_fetch_add(&l->win, 1);
+        while (ticket != atomic_load(&l->wout)) relax(&spins); // Writers go in ticket order.
+        unsigned w = PF_PRES | (ticket & PF_PHID);
+        ticket = atomic_fetch_add(&l->rin, w); // Block new readers...
+        while (ticket != atomic_load(&l->rout)) relax(&spins); // ...and wait for the current ones.
+        break;
+    }
+    case RW_BIGREADER:
+        pthread_mutex_lock(&l->writerlock);
+        atomic_store(&l->writer, 1); // Stop new readers, then wait for every slot to drain.
+        for (int i = 0; i < RW_SLOTS; i++)
+            while (atomic_load(&l->slots[i].readers) > 0) relax(&spins);
+        break;
+    }
+}
+
+void rw_wrunlock(rwlock *l) {
+    switch (l->kind) {
+    case RW_READPREF:
+        sem_post(&l->wrt);
+        break;
+    case RW_WRITEPREF:
+        pthread_mutex_lock(&l->m);
+        l->writing = 0;
+        if (l->waitingwriters > 0) pthread_cond_signal(&l->writeok);
+        else pthread_cond_broadcast(&l->readok);
+        pthread_mutex_unlock(&l->m);
+        break;
+    case RW_PHASEFAIR:
+        atomic_fetch_and(&l->rin, ~PF_WBITS); // Release the waiting readers.
+        atomic_fetch_add(&l->wout, 1);         // Next writer's turn.
+        break;
+    case RW_BIGREADER:
+        atomic_store(&l->writer, 0);
+        pthread_mutex_unlock(&l->writerlock);
+        break;
+    }
+}
+
+typedef struct {
+    rwlock *l;
+    _Atomic int *data;          // DATA_WORDS shared words.
+    _Atomic int *stop;
+    long workns;                // Time spent inside the critical section.
+    int id;
+    long ops, torn;             // Operations done; readers: inconsistent reads seen.
+    long waitns, maxwaitns;     // Time spent acquiring the lock.
+} rwthread;
+
+long now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+void spinfor(long ns) {
+    long start = now_ns();
+    while (now_ns() - start < ns)
+        ;
+}
+
+// Copy the shared words into copy[], spending workns inside the read
+// section. self is the reader's index (RW_RCU gives each reader a slot).
+// Returns the ns spent before the read section that counted began: lock
+// wait, or seqlock retries.
+long rw_read(rwlock *l, int self, _Atomic int *data, int copy[], long workns) {
+    long start = now_ns(), begin;
+    int i, spins = 0;
+    if (l->kind == RW_SEQLOCK) {
+        while (1) {
+            unsigned s = atomic_load_explicit(&l->seq, memory_order_acquire);
+            if (s & 1) { // A writer is in the middle of an update.
+                relax(&spins);
+                continue;
+            }
+            begin = now_ns();
+            for (i = 0; i < DATA_WORDS; i++)
+                copy[i] = atomic_load_explicit(&data[i], memory_order_relaxed);
+            spinfor(workns);
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&l->seq, memory_order_relaxed) == s) return begin - start;
+        }
+    }
+    if (l->kind == RW_RCU) {
+        readerslot *me = &l->slots[self % RW_SLOTS];
+        atomic_store(&me->readers, atomic_load(&l->epoch)); // Enter: post the epoch first...
+        snapshot *snap = atomic_load_explicit(&l->current, memory_order_acquire); // ...then load.
+        for (i = 0; i < DATA_WORDS; i++)
+            copy[i] = snap->words[i];
+        spinfor(workns);
+        atomic_store_explicit(&me->readers, 0, memory_order_release); // Leave.
+        return 0;
     }
+    int token = rw_rdlock(l);
+    begin = now_ns();
+    for (i = 0; i < DATA_WORDS; i++)
+        copy[i] = atomic_load_explicit(&data[i], memory_order_relaxed);
+    spinfor(workns);
+    rw_rdunlock(l, token);
+    return begin - start;
 }
+
+// Set every shared word to value, spending workns inside the write section.
+// Returns the ns spent waiting for the lock.
+long rw_write(rwlock *l, _Atomic int *data, int value, long workns) {
+    long start = now_ns(), wait;
+    int i, spins = 0;
+    if (l->kind == RW_SEQLOCK) {
+        pthread_mutex_lock(&l->writerlock);
+        wait = now_ns() - start;
+        unsigned s = atomic_load_explicit(&l->seq, memory_order_relaxed);
+        atomic_store_explicit(&l->seq, s + 1, memory_order_relaxed); // Odd: readers will retry.
+        atomic_thread_fence(memory_order_release);
+        for (i = 0; i < DATA_WORDS; i++)
+            atomic_store_explicit(&data[i], value, memory_order_relaxed);
+        spinfor(workns);
+        atomic_store_explicit(&l->seq, s + 2, memory_order_release);
+        pthread_mutex_unlock(&l->writerlock);
+        return wait;
+    }
+    if (l->kind == RW_RCU) {
+        snapshot *next = malloc(sizeof(snapshot));
+        for (i = 0; i < DATA_WORDS; i++) // Build the new version privately.
+            next->words[i] = value;
+        pthread_mutex_lock(&l->writerlock);
+        wait = now_ns() - start;
+        spinfor(workns);
+        snapshot *old = atomic_exchange(&l->current, next); // Publish.
+        // Grace period: readers that may still hold old posted an epoch
+        // older than the one we now start.
+        int e = atomic_fetch_add(&l->epoch, 1) + 1;
+        for (i = 0; i < RW_SLOTS; i++) {
+            int in;
+            while ((in = atomic_load(&l->slots[i].readers)) != 0 && in < e) relax(&spins);
+        }
+        pthread_mutex_unlock(&l->writerlock);
+        free(old);
+        return wait;
+    }
+    rw_wrlock(l);
+    wait = now_ns() - start;
+    for (i = 0; i < DATA_WORDS; i++)
+        atomic_store_explicit(&data[i], value, memory_order_relaxed);
+    spinfor(workns);
+    rw_wrunlock(l);
+    return wait;
+}
+
+void *benchreader(void *arg) {
+    rwthread *t = arg;
+    int copy[DATA_WORDS], i;
+    while (!atomic_load_explicit(t->stop, memory_order_relaxed)) {
+        long wait = rw_read(t->l, t->id, t->data, copy, t->workns);
+        for (i = 1; i < DATA_WORDS; i++)
+            if (copy[i] != copy[0]) {
+                t->torn++;
+                break;
+            }
+        t->waitns += wait;
+        if (wait > t->maxwaitns) t->maxwaitns = wait;
+        t->ops++;
+    }
+    return NULL;
+}
+
+void *benchwriter(void *arg) {
+    rwthread *t = arg;
+    while (!atomic_load_explicit(t->stop, memory_order_relaxed)) {
+        long wait = rw_write(t->l, t->data, t->id * 1000000 + (int)t->ops, t->workns);
+        t->waitns += wait;
+        if (wait > t->maxwaitns) t->maxwaitns = wait;
+        t->ops++;
+    }
+    return NULL;
+}
+
+// Run readers and writers against one lock kind for the given time and
+// report read/write throughput and writer wait times.
+void runbench(int kind, int readers, int writers, double seconds, long readns, long writens) {
+    rwlock l;
+    _Atomic int data[DATA_WORDS] = {0}, stop = 0;
+    pthread_t tid[readers + writers];
+    rwthread *t = calloc(readers + writers, sizeof(rwthread));
+    long reads = 0, writes = 0, torn = 0, wwait = 0, wmax = 0, rmax = 0;
+    int i;
+    if (kind == RW_RCU && readers > RW_SLOTS) {
+        printf("%-9s skipped: at most %d readers\n", rwname[kind], RW_SLOTS);
+        free(t);
+        return;
+    }
+    rw_init(&l, kind);
+    for (i = 0; i < readers + writers; i++) {
+        t[i].l = &l;
+        t[i].data = data;
+        t[i].stop = &stop;
+        t[i].id = i;
+        t[i].workns = i < readers ? readns : writens;
+        pthread_create(&tid[i], NULL, i < readers ? benchreader : benchwriter, &t[i]);
+    }
+    struct timespec ts = {(time_t)seconds, (long)((seconds - (time_t)seconds) * 1e9)};
+    nanosleep(&ts, NULL);
+    atomic_store(&stop, 1);
+    for (i = 0; i < readers + writers; i++) {
+        pthread_join(tid[i], NULL);
+        if (i < readers) {
+            reads += t[i].ops;
+            torn += t[i].torn;
+            if (t[i].maxwaitns > rmax) rmax = t[i].maxwaitns;
+        } else {
+            writes += t[i].ops;
+            wwait += t[i].waitns;
+            if (t[i].maxwaitns > wmax) wmax = t[i].maxwaitns;
+        }
+    }
+    char mix[32];
+    snprintf(mix, sizeof(mix), "%dR/%dW", readers, writers);
+    printf("%-9s %-9s %12.0f reads/s %10.0f writes/s  writer wait avg %8.1f us max %9.1f us  "
+           "reader wait max %9.1f us%s\n",
+           rwname[kind], mix, reads / seconds, writes / seconds, writes ? wwait / 1e3 / writes : 0.0,
+           wmax / 1e3, rmax / 1e3, torn ? "  TORN READS" : "");
+    rw_destroy(&l);
+    free(t);
+}
+
+// ./a.out scale <lock|all> <max readers> <seconds> [read ns]
+// Read-only runs with 1, 2, 4, ... readers, to see how reads scale.
+int scalemain(int argc, char *argv[]) {
+    const char *mode = argc > 2 ? argv[2] : "all";
+    int maxreaders = argc > 3 ? atoi(argv[3]) : 8, k, n;
+    double seconds = argc > 4 ? atof(argv[4]) : 0.5;
+    long readns = argc > 5 ? atol(argv[5]) : 100;
+    if (maxreaders < 1 || seconds <= 0 || readns < 0) {
+        printf("usage: %s scale <all|lock> <max readers> <seconds> [read ns]\n", argv[0]);
+        return 1;
+    }
+    for (k = 0; k < RW_KINDS; k++)
+        if (strcmp(mode, "all") == 0 || strcmp(mode, rwname[k]) == 0)
+            for (n = 1; n <= maxreaders; n *= 2)
+                runbench(k, n, 0, seconds, readns, 0);
+    return 0;
+}
+
+// ./a.out bench <lock|all> <readers> <writers> <seconds> [read ns] [write ns]
+int benchmain(int argc, char *argv[]) {
+    const char *mode = argc > 2 ? argv[2] : "all";
+    int readers = argc > 3 ? atoi(argv[3]) : 4, writers = argc > 4 ? atoi(argv[4]) : 1, k, found = 0;
+    double seconds = argc > 5 ? atof(argv[5]) : 1.0;
+    long readns = argc > 6 ? atol(argv[6]) : 100, writens = argc > 7 ? atol(argv[7]) : 100;
+    for (k = 0; k < RW_KINDS; k++)
+        if (strcmp(mode, "all") == 0 || strcmp(mode, rwname[k]) == 0) found = 1;
+    if (!found || readers < 0 || writers < 0 || readers + writers < 1 || seconds <= 0 || readns < 0 ||
+        writens < 0) {
+        printf("usage: %s bench <all", argv[0]);
+        for (k = 0; k < RW_KINDS; k++) printf("|%s", rwname[k]);
+        printf("> <readers> <writers> <seconds> [read ns] [write ns]\n");
+        return 1;
+    }
+    for (k = 0; k < RW_KINDS; k++)
+        if (strcmp(mode, "all") == 0 || strcmp(mode, rwname[k]) == 0)
+            runbench(k, readers, writers, seconds, readns, writens);
+    return 0;
+}
+// Load generator: a fixed number of operations per thread, each a read or a
+// write in the given ratio, with log2 histograms of how long each operation
+// waited for the lock and how long it held it.
+#define HIST_BUCKETS 32         // Bucket b counts times in [2^b, 2^(b+1)) ns.
+#define H_READWAIT 0
+#define H_READHOLD 1
+#define H_WRITEWAIT 2
+#define H_WRITEHOLD 3
+
+typedef struct {
+    rwlock *l;
+    _Atomic int *data;
+    int id, readpct;            // Percentage of operations that are reads.
+    long ops, readns, writens;
+    long reads, writes, torn;
+    long hist[4][HIST_BUCKETS];
+} loadthread;
+
+void histadd(long hist[], long ns) {
+    int b = 0;
+    while (b < HIST_BUCKETS - 1 && ns >= 2L << b) b++;
+    hist[b]++;
+}
+
+// Upper edge (ns) of the bucket holding the p-th percentile.
+long histpercentile(long hist[], double pct) {
+    long total = 0, seen = 0;
+    int b;
+    for (b = 0; b < HIST_BUCKETS; b++) total += hist[b];
+    for (b = 0; b < HIST_BUCKETS; b++) {
+        seen += hist[b];
+        if (seen > (long)(total * pct / 100.0)) return 2L << b;
+    }
+    return 0;
+}
+
+void *loadworker(void *arg) {
+    loadthread *t = arg;
+    unsigned rng = 2463534242u + t->id * 7919; // xorshift32, seeded per thread.
+    int copy[DATA_WORDS], i;
+    for (long n = 0; n < t->ops; n++) {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        long start = now_ns(), wait;
+        if ((int)(rng % 100) < t->readpct) {
+            wait = rw_read(t->l, t->id, t->data, copy, t->readns);
+            histadd(t->hist[H_READWAIT], wait);
+            histadd(t->hist[H_READHOLD], now_ns() - start - wait);
+            for (i = 1; i < DATA_WORDS; i++)
+                if (copy[i] != copy[0]) {
+                    t->torn++;
+                    break;
+                }
+            t->reads++;
+        } else {
+            wait = rw_write(t->l, t->data, t->id * 1000000 + (int)n, t->writens);
+            histadd(t->hist[H_WRITEWAIT], wait);
+            histadd(t->hist[H_WRITEHOLD], now_ns() - start - wait);
+            t->writes++;
+        }
+    }
+    return NULL;
+}
+
+void runload(int kind, int threads, long ops, int readpct, long readns, long writens) {
+    rwlock l;
+    _Atomic int data[DATA_WORDS] = {0};
+    pthread_t tid[threads];
+    loadthread *t = calloc(threads, sizeof(loadthread));
+    long hist[4][HIST_BUCKETS] = {{0}}, reads = 0, writes = 0, torn = 0;
+    const char *title[] = {"read wait", "read hold", "write wait", "write hold"};
+    int i, h, b;
+    if (kind == RW_RCU && threads > RW_SLOTS) {
+        printf("%-9s skipped: at most %d threads\n", rwname[kind], RW_SLOTS);
+        free(t);
+        return;
+    }
+    rw_init(&l, kind);
+    long start = now_ns();
+    for (i = 0; i < threads; i++) {
+        t[i].l = &l;
+        t[i].data = data;
+        t[i].id = i;
+        t[i].readpct = readpct;
+        t[i].ops = ops;
+        t[i].readns = readns;
+        t[i].writens = writens;
+        pthread_create(&tid[i], NULL, loadworker, &t[i]);
+    }
+    for (i = 0; i < threads; i++) {
+        pthread_join(tid[i], NULL);
+        reads += t[i].reads;
+        writes += t[i].writes;
+        torn += t[i].torn;
+        for (h = 0; h < 4; h++)
+            for (b = 0; b < HIST_BUCKETS; b++)
+                hist[h][b] += t[i].hist[h][b];
+    }
+    double elapsed = (now_ns() - start) / 1e9;
+    printf("%s: %d threads, %ld reads + %ld writes in %.3f s (%.0f ops/s)%s\n", rwname[kind], threads, reads,
+           writes, elapsed, (reads + writes) / elapsed, torn ? "  TORN READS" : "");
+    printf("  %-12s", "ns <");
+    for (h = 0; h < 4; h++) printf(" %11s", title[h]);
+    printf("\n");
+    for (b = 0; b < HIST_BUCKETS; b++) {
+        if (!hist[0][b] && !hist[1][b] && !hist[2][b] && !hist[3][b]) continue;
+        printf("  %-12ld", 2L << b);
+        for (h = 0; h < 4; h++) printf(" %11ld", hist[h][b]);
+        printf("\n");
+    }
+    printf("  %-12s", "p99 ns <");
+    for (h = 0; h < 4; h++) printf(" %11ld", histpercentile(hist[h], 99));
+    printf("\n");
+    rw_destroy(&l);
+    free(t);
+}
+
+// ./a.out load <lock|all> <threads> <ops per thread> <reads:writes> [read ns] [write ns]
+int loadmain(int argc, char *argv[]) {
+    const char *mode = argc > 2 ? argv[2] : "all";
+    int threads = argc > 3 ? atoi(argv[3]) : 4, rd = 9, wr = 1, k, found = 0;
+    long ops = argc > 4 ? atol(argv[4]) : 100000;
+    long readns = argc > 6 ? atol(argv[6]) : 100, writens = argc > 7 ? atol(argv[7]) : 100;
+    if (argc > 5 && sscanf(argv[5], "%d:%d", &rd, &wr) != 2) rd = -1;
+    for (k = 0; k < RW_KINDS; k++)
+        if (strcmp(mode, "all") == 0 || strcmp(mode, rwname[k]) == 0) found = 1;
+    if (!found || threads < 1 || ops < 1 || rd < 0 || wr < 0 || rd + wr < 1 || readns < 0 || writens < 0) {
+        printf("usage: %s load <all|lock> <threads> <ops per thread> <reads:writes> [read ns] [write ns]\n",
+               argv[0]);
+        return 1;
+    }
+    for (k = 0; k < RW_KINDS; k++)
+        if (strcmp(mode, "all") == 0 || strcmp(mode, rwname[k]) == 0)
+            runload(k, threads, ops, 100 * rd / (rd + wr), readns, writens);
+    return 0;
+}
+
 // Explanation of Specific Keywords and Libraries 
 /*
 #include: Preprocessor directive used to include standard libraries for functionalities (e.g., I/O operations, threading).
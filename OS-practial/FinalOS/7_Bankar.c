@@ -4,27 +4,60 @@
 // Line-by-Line Explanation and Code Comments
 
 #include <stdio.h> // Standard input/output library.
+#include <stdlib.h> // malloc() and qsort() for the dynamically sized tables.
+#include <time.h> // clock_gettime() to time the safety checks.
+#include <pthread.h> // Worker threads and the allocator lock.
+#include <stdatomic.h> // Shared memo table for the safe-sequence search.
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h> // SIMD compare/add for the vectorised safety check.
+#endif
+
+#if defined(__AVX2__) // Resources per vector; need and allocate rows are padded to a multiple.
+#define VECW 8
+#elif defined(__SSE2__)
+#define VECW 4
+#else
+#define VECW 1
+#endif
 
 struct process {
-    int max[10];       // Maximum resources needed by the process.
-    int allocate[10];  // Resources currently allocated to the process.
-    int need[10];      // Remaining resources needed by the process (max - allocate).
-} p[10]; // Array of structures to hold details of up to 10 processes.
+    int *max;       // Maximum resources needed by the process.
+    int *allocate;  // Resources currently allocated to the process.
+    int *need;      // Remaining resources needed by the process (max - allocate).
+    int *request;   // Pending request the process is blocked on (deadlock detection).
+} *p; // Process table, sized at run time for n processes and m resources.
+
+// need and allocate rows live in two contiguous, 32-byte aligned matrices with
+// rowstride ints per row (m padded with zeros to whole vectors).
+int *needrows, *allocrows, rowstride;
 
 int n, m; // Number of processes (n) and number of resources (m).
-void input(int[]); // Function prototype for input.
+void allocatetables(); // Function prototype to size the process table.
+void input(int[m]); // Function prototype for input.
 void display(); // Function prototype for displaying process details.
-int isSafestate(int[], int[]); // Function prototype to check if the system is in a safe state.
-int safetyalgorithm(int[], int[]); // Function prototype for the safety algorithm.
+int isSafestate(int[m], int[n]); // Function prototype to check if the system is in a safe state.
+int safetyalgorithm(int[m], int[n]); // Function prototype for the safety algorithm.
+int fastsafetyalgorithm(int[m], int[n]); // Function prototype for the sorted work-queue safety algorithm.
+int simdsafetyalgorithm(int[m], int[n]); // Function prototype for the vectorised safety algorithm.
+void report(int, int[n], double); // Function prototype to print a safety result.
+double now_us(); // Function prototype for a microsecond clock.
+int requestresources(int, int[m], int[m]); // Function prototype for the resource-request algorithm.
+void releaseresources(int, int[m], int[m]); // Function prototype to return resources.
+void eventstream(int[m]); // Function prototype to process request/release events.
+void allocatorservice(int[m]); // Function prototype for the threaded allocator benchmark.
+void detectdeadlock(int[m]); // Function prototype for deadlock detection.
+void enumeratesequences(int[m]); // Function prototype to count and list all safe sequences.
 
 int main() {
-    int i;
+    int ch, safe;
+    double start;
     printf("\nEnter No of processes: "); // Prompt for number of processes.
     scanf("%d", &n);
     printf("Enter no of resources: "); // Prompt for number of resources.
     scanf("%d", &m);
-    int available[m]; // Array to hold available resources.
-    int safesequence[n]; // Array to hold the safe sequence of processes.
+    allocatetables(); // Size the process table for n processes and m resources.
+    int *available = malloc(m * sizeof(int)); // Array to hold available resources.
+    int *safesequence = malloc(n * sizeof(int)); // Array to hold the safe sequence of processes.
 
     printf("\n*****Enter details of process*****");
     input(available); // Call to input function to gather process data.
@@ -34,14 +67,95 @@ int main() {
     if (isSafestate(available, safesequence)) {
         printf("\n\tSYSTEM IS IN SAFE STATE...");
         printf("\nsafesequence is: ");
-        for (i = 0; i < n; i++)
+        for (int i = 0; i < n; i++)
             printf("P%d -> ", safesequence[i]); // Display the safe sequence.
     } else {
         printf("\nSYSTEM IS IN UNSAFE STATE!!!");
     }
+
+    // Menu to rerun the check with a particular algorithm and time it.
+    do {
+        printf("\n\n\t*********** MENU ***********");
+        printf("\n\t1:SAFETY ALGORITHM (repeated sweep)\n\t2:SAFETY ALGORITHM (sorted need queues)");
+        printf("\n\t3:REQUEST/RELEASE STREAM\n\t4:ALLOCATOR SERVICE (threads)\n\t5:DEADLOCK DETECTION");
+        printf("\n\t6:ENUMERATE SAFE SEQUENCES\n\t7:SAFETY ALGORITHM (SIMD rows)\n\t0:EXIT");
+        printf("\n\tEnter your choice: ");
+        if (scanf("%d", &ch) != 1) break; // Stop at end of input.
+        switch (ch) {
+            case 1: // Original O(n*n*m) sweep.
+                start = now_us();
+                safe = safetyalgorithm(available, safesequence);
+                report(safe, safesequence, now_us() - start);
+                break;
+            case 2: // O(n*m log n) sorted work-queue check.
+                start = now_us();
+                safe = fastsafetyalgorithm(available, safesequence);
+                report(safe, safesequence, now_us() - start);
+                break;
+            case 3: // Grant or deny a stream of requests and releases.
+                eventstream(available);
+                break;
+            case 4: // Real threads acquiring and releasing through the Banker.
+                allocatorservice(available);
+                break;
+            case 5: // Find deadlocked sets from pending requests.
+                detectdeadlock(available);
+                break;
+            case 6: // Count every safe sequence and pick the best one.
+                enumeratesequences(available);
+                break;
+            case 7: // Sweep with whole-row vector compares.
+                start = now_us();
+                safe = simdsafetyalgorithm(available, safesequence);
+                report(safe, safesequence, now_us() - start);
+                break;
+        }
+    } while (ch != 0);
+
+    free(available);
+    free(safesequence);
     return 0; // End of the program.
 }
 
+// Function to allocate the process table once n and m are known.
+void allocatetables() {
+    int i;
+    rowstride = (m + VECW - 1) / VECW * VECW;
+    p = malloc(n * sizeof(struct process));
+    needrows = aligned_alloc(32, ((size_t)n * rowstride * sizeof(int) + 31) / 32 * 32);
+    allocrows = aligned_alloc(32, ((size_t)n * rowstride * sizeof(int) + 31) / 32 * 32);
+    for (i = 0; i < n * rowstride; i++)
+        needrows[i] = allocrows[i] = 0; // Padding columns stay zero.
+    for (i = 0; i < n; i++) {
+        p[i].max = malloc(m * sizeof(int));
+        p[i].allocate = &allocrows[i * rowstride];
+        p[i].need = &needrows[i * rowstride];
+        p[i].request = calloc(m, sizeof(int));
+    }
+}
+
+double now_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// Function to print the outcome of a safety check.
+void report(int safe, int safesequence[n], double us) {
+    int i;
+    if (safe) {
+        printf("\n\tSYSTEM IS IN SAFE STATE...");
+        if (n <= 50) { // Long sequences are not worth printing.
+            printf("\nsafesequence is: ");
+            for (i = 0; i < n; i++)
+                printf("P%d -> ", safesequence[i]);
+        }
+    } else {
+        printf("\nSYSTEM IS IN UNSAFE STATE!!!");
+    }
+    printf("\nChecked %d processes x %d resources in %.1f us", n, m, us);
+}
+
 // Function to input the details of processes and available resources.
 void input(int available[m]) {
     int i, j;
@@ -66,6 +180,10 @@ void input(int available[m]) {
 // Function to display the process details.
 void display() {
     int i, j;
+    if (n > 50) { // Thousands of rows would bury the result.
+        printf("\n\t(%d processes, table not shown)\n", n);
+        return;
+    }
     printf("\n\tPID\tALLOCATE\tMAX\t\tNEED\n");
     for (i = 0; i < n; i++) {
         printf("\tP%d\t", i);
@@ -132,6 +250,866 @@ int safetyalgorithm(int available[m], int safesequence[n]) {
         return 1; // System is in a safe state.
     return 0; // System is not in a safe state.
 }
+
+// Sorted work-queue safety algorithm. For every resource j the processes are
+// sorted by need[j], and ptr[j] marks how many of them work[j] already covers.
+// unsat[i] counts the resources process i is still waiting for; when it drops to
+// zero the process joins the ready queue. Finishing a process only moves the
+// pointers forward, so each (process, resource) pair is passed at most once and
+// the whole check is O(n*m log n) for the sorts plus O(n*m) for the rest.
+// With pending = 1 the same reduction compares request[] instead of need[],
+// which is the deadlock detection algorithm.
+int sortres; // Resource column used by bydemand().
+int sortpending; // Which vector bydemand() compares.
+
+int *demand(int i, int pending) {
+    return pending ? p[i].request : p[i].need;
+}
+
+int bydemand(const void *a, const void *b) {
+    return demand(*(const int *)a, sortpending)[sortres] - demand(*(const int *)b, sortpending)[sortres];
+}
+
+// Returns how many processes can finish; their order is written to ready[].
+int reduction(int available[m], int ready[n], int pending) {
+    int i, j, k = 0, head = 0;
+    int *work = malloc(m * sizeof(int)); // Resources currently available.
+    int *order = malloc((long)n * m * sizeof(int)); // order[j*n..]: processes by demand[j].
+    int *ptr = calloc(m, sizeof(int)); // Processes covered in each order[] row.
+    int *unsat = malloc(n * sizeof(int)); // Resources each process still lacks.
+
+    for (i = 0; i < n; i++)
+        unsat[i] = m;
+    sortpending = pending;
+    for (j = 0; j < m; j++) {
+        work[j] = available[j];
+        for (i = 0; i < n; i++)
+            order[j * n + i] = i;
+        sortres = j;
+        qsort(order + j * n, n, sizeof(int), bydemand);
+    }
+
+    // Advance every pointer over the processes the initial work already covers.
+    for (j = 0; j < m; j++) {
+        while (ptr[j] < n && demand(order[j * n + ptr[j]], pending)[j] <= work[j]) {
+            if (--unsat[order[j * n + ptr[j]]] == 0)
+                ready[k++] = order[j * n + ptr[j]]; // Needs nothing more: can run.
+            ptr[j]++;
+        }
+    }
+
+    // Let ready processes finish and release their allocation.
+    while (head < k) {
+        i = ready[head++];
+        for (j = 0; j < m; j++) {
+            if (p[i].allocate[j] == 0)
+                continue; // work[j] did not change.
+            work[j] += p[i].allocate[j];
+            while (ptr[j] < n && demand(order[j * n + ptr[j]], pending)[j] <= work[j]) {
+                if (--unsat[order[j * n + ptr[j]]] == 0)
+                    ready[k++] = order[j * n + ptr[j]];
+                ptr[j]++;
+            }
+        }
+    }
+
+    free(work);
+    free(order);
+    free(ptr);
+    free(unsat);
+    return k;
+}
+
+int fastsafetyalgorithm(int available[m], int safesequence[n]) {
+    return reduction(available, safesequence, 0) == n; // Safe only if every process could finish.
+}
+
+// Vectorised safety algorithm. need[] and allocate[] rows are contiguous and
+// padded (see allocatetables()), so a row is tested with one compare per 8
+// (AVX2) or 4 (SSE2) resources, stopping at the first vector with a shortfall,
+// and released into work[] with one add per vector. Unfinished processes are
+// kept in a list that is compacted on every sweep, so finished rows are never
+// read again. Build with -mavx2 (or -march=native) for AVX2; plain x86-64 gets
+// SSE2 and other targets the scalar loop.
+// 1 if need row a[0..mp-1] <= w[0..mp-1] in every column.
+int rowfits(const int *a, const int *w, int mp) {
+    int j;
+#if defined(__AVX2__)
+    for (j = 0; j < mp; j += 8) {
+        __m256i gt = _mm256_cmpgt_epi32(_mm256_load_si256((const __m256i *)(a + j)),
+                                        _mm256_load_si256((const __m256i *)(w + j)));
+        if (!_mm256_testz_si256(gt, gt)) return 0; // Some resource is short.
+    }
+#elif defined(__SSE2__)
+    for (j = 0; j < mp; j += 4) {
+        __m128i gt = _mm_cmpgt_epi32(_mm_load_si128((const __m128i *)(a + j)),
+                                     _mm_load_si128((const __m128i *)(w + j)));
+        if (_mm_movemask_epi8(gt)) return 0;
+    }
+#else
+    for (j = 0; j < mp; j++)
+        if (a[j] > w[j]) return 0;
+#endif
+    return 1;
+}
+
+// w[0..mp-1] += a[0..mp-1]
+void rowadd(int *w, const int *a, int mp) {
+    int j;
+#if defined(__AVX2__)
+    for (j = 0; j < mp; j += 8)
+        _mm256_store_si256((__m256i *)(w + j), _mm256_add_epi32(_mm256_load_si256((const __m256i *)(w + j)),
+                                                                _mm256_load_si256((const __m256i *)(a + j))));
+#elif defined(__SSE2__)
+    for (j = 0; j < mp; j += 4)
+        _mm_store_si128((__m128i *)(w + j), _mm_add_epi32(_mm_load_si128((const __m128i *)(w + j)),
+                                                          _mm_load_si128((const __m128i *)(a + j))));
+#else
+    for (j = 0; j < mp; j++)
+        w[j] += a[j];
+#endif
+}
+
+int simdsafetyalgorithm(int available[m], int safesequence[n]) {
+    int i, j, k = 0, left = n, kept, progress = 1, mp = rowstride;
+    int *w = aligned_alloc(32, (mp * sizeof(int) + 31) / 32 * 32), *pending = malloc(n * sizeof(int));
+
+    for (i = 0; i < n; i++)
+        pending[i] = i;
+    for (j = 0; j < mp; j++)
+        w[j] = j < m ? available[j] : 0;
+
+    while (progress && left > 0) {
+        progress = 0;
+        kept = 0;
+        for (i = 0; i < left; i++) {
+            int pid = pending[i];
+            if (rowfits(p[pid].need, w, mp)) {
+                rowadd(w, p[pid].allocate, mp); // Process finishes and releases.
+                safesequence[k++] = pid;
+                progress = 1;
+            } else {
+                pending[kept++] = pid; // Try again on the next sweep.
+            }
+        }
+        left = kept;
+    }
+    free(w);
+    free(pending);
+    return left == 0;
+}
+
+// Resource-request algorithm with incremental safety checks. The last safe
+// sequence seq[] is kept together with work[k], the resources available just
+// before seq[k] runs. When process i at position t asks for req:
+//  - processes after t see exactly the same work as before, because i gives
+//    the request back when it finishes, and i itself still fits;
+//  - processes before t see work[k] - req, so only they need rechecking, and
+//    only on the resources that req actually touches.
+// If one of them no longer fits at position k, seq[0..k-1] is still valid and
+// only seq[k..n-1] is searched again. A release never makes a safe state
+// unsafe: it just adds to work[0..t].
+int *seq; // Last safe sequence.
+int *seqpos; // Position of each process in seq[].
+int *work; // work[k*m + j]: resource j available before seq[k] runs.
+int havesequence = 0; // 1 while seq[] and work[] describe the current state.
+long fastgrants, partialchecks, fullchecks; // How each granted request was verified.
+
+// Search for a safe order of seq[from..n-1] starting from w[], writing the new
+// order and work vectors to neworder[] and newwork[]. Returns 1 if all fit.
+int resumesafety(int from, int w[], int neworder[], int newwork[]) {
+    int r = n - from, i, j, k = 0, proceed = 1;
+    int *placed = calloc(r, sizeof(int));
+    int *cur = malloc(m * sizeof(int));
+    for (j = 0; j < m; j++)
+        cur[j] = w[j];
+    while (proceed && k < r) {
+        proceed = 0;
+        for (i = 0; i < r; i++) {
+            int pid = seq[from + i];
+            if (placed[i]) continue;
+            for (j = 0; j < m && p[pid].need[j] <= cur[j]; j++)
+                ;
+            if (j < m) continue; // Not enough of resource j yet.
+            for (j = 0; j < m; j++) {
+                newwork[k * m + j] = cur[j];
+                cur[j] += p[pid].allocate[j];
+            }
+            neworder[k++] = pid;
+            placed[i] = 1;
+            proceed = 1;
+        }
+    }
+    free(placed);
+    free(cur);
+    return k == r;
+}
+
+// Copy a resumed order back into seq[] / work[] from position from.
+void commitsequence(int from, int neworder[], int newwork[]) {
+    int k, j;
+    for (k = from; k < n; k++) {
+        seq[k] = neworder[k - from];
+        seqpos[seq[k]] = k;
+        for (j = 0; j < m; j++)
+            work[k * m + j] = newwork[(k - from) * m + j];
+    }
+}
+
+// Full safety check of the current state, rebuilding seq[] and work[].
+int buildsequence(int available[m]) {
+    int i, *neworder = malloc(n * sizeof(int)), *newwork = malloc((long)n * m * sizeof(int));
+    if (seq == NULL) {
+        seq = malloc(n * sizeof(int));
+        seqpos = malloc(n * sizeof(int));
+        work = malloc((long)n * m * sizeof(int));
+    }
+    for (i = 0; i < n; i++)
+        seq[i] = i; // Search over every process.
+    havesequence = resumesafety(0, available, neworder, newwork);
+    if (havesequence)
+        commitsequence(0, neworder, newwork);
+    free(neworder);
+    free(newwork);
+    fullchecks++;
+    return havesequence;
+}
+
+// Apply (sign 1) or undo (sign -1) an allocation of req to process pid.
+void applyrequest(int pid, int req[m], int available[m], int sign) {
+    int j;
+    for (j = 0; j < m; j++) {
+        available[j] -= sign * req[j];
+        p[pid].allocate[j] += sign * req[j];
+        p[pid].need[j] -= sign * req[j];
+    }
+}
+
+// Returns 1 if granted, 0 if the process must wait for resources, -1 if the
+// grant would be unsafe and -2 if the request exceeds the declared maximum.
+int requestresources(int pid, int req[m], int available[m]) {
+    int j, k, t;
+    for (j = 0; j < m; j++) {
+        if (req[j] > p[pid].need[j]) return -2; // Exceeds its maximum claim.
+    }
+    for (j = 0; j < m; j++) {
+        if (req[j] > available[j]) return 0; // Not available right now.
+    }
+    applyrequest(pid, req, available, 1); // Pretend to allocate.
+
+    if (!havesequence) { // No safe sequence to start from.
+        if (buildsequence(available)) return 1;
+        applyrequest(pid, req, available, -1);
+        return -1;
+    }
+
+    // Recheck the processes ahead of pid against the reduced work.
+    t = seqpos[pid];
+    for (k = 0; k < t; k++) {
+        int *w = &work[k * m], q = seq[k];
+        for (j = 0; j < m; j++) {
+            if (req[j] > 0 && p[q].need[j] > w[j] - req[j]) break;
+        }
+        if (j < m) break; // seq[k] no longer fits.
+    }
+    if (k == t) { // Old sequence still works.
+        for (k = 0; k <= t; k++)
+            for (j = 0; j < m; j++)
+                work[k * m + j] -= req[j];
+        fastgrants++;
+        return 1;
+    }
+
+    // seq[0..k-1] is still valid; search the rest again from there.
+    int *w = malloc(m * sizeof(int)), *neworder = malloc((n - k) * sizeof(int));
+    int *newwork = malloc((long)(n - k) * m * sizeof(int)), safe;
+    for (j = 0; j < m; j++)
+        w[j] = work[k * m + j] - req[j];
+    safe = resumesafety(k, w, neworder, newwork);
+    if (safe) {
+        for (t = 0; t < k; t++)
+            for (j = 0; j < m; j++)
+                work[t * m + j] -= req[j];
+        commitsequence(k, neworder, newwork);
+        partialchecks++;
+    } else {
+        applyrequest(pid, req, available, -1); // Roll back; old sequence still holds.
+    }
+    free(w);
+    free(neworder);
+    free(newwork);
+    return safe ? 1 : -1;
+}
+
+// Return rel units from process pid; its need grows by the same amount.
+void releaseresources(int pid, int rel[m], int available[m]) {
+    int j, k;
+    for (j = 0; j < m; j++) {
+        if (rel[j] > p[pid].allocate[j]) rel[j] = p[pid].allocate[j]; // Cannot give back more than it holds.
+    }
+    applyrequest(pid, rel, available, -1);
+    if (!havesequence) {
+        buildsequence(available); // The release may have made the state safe.
+        return;
+    }
+    for (k = 0; k <= seqpos[pid]; k++)
+        for (j = 0; j < m; j++)
+            work[k * m + j] += rel[j];
+}
+
+// Read "R pid r1..rm" (request) and "L pid r1..rm" (release) events until "E".
+void eventstream(int available[m]) {
+    char op;
+    int pid, j, result, *v = malloc(m * sizeof(int));
+    long events = 0, granted = 0, waits = 0, unsafe = 0, errors = 0;
+    double start;
+    fastgrants = partialchecks = fullchecks = 0;
+    buildsequence(available); // Start from a full check of the current state.
+    printf("\nEnter events: R pid r1..r%d to request, L pid r1..r%d to release, E to end\n", m, m);
+    start = now_us();
+    while (scanf(" %c", &op) == 1 && op != 'E' && op != 'e') {
+        if (scanf("%d", &pid) != 1) break;
+        for (j = 0; j < m; j++)
+            scanf("%d", &v[j]);
+        if (pid < 0 || pid >= n) {
+            printf("P%d: no such process\n", pid);
+            continue;
+        }
+        events++;
+        if (op == 'L' || op == 'l') {
+            releaseresources(pid, v, available);
+            if (n <= 50) printf("P%d: RELEASED\n", pid);
+            continue;
+        }
+        result = requestresources(pid, v, available);
+        if (result == 1) granted++;
+        else if (result == 0) waits++;
+        else if (result == -1) unsafe++;
+        else errors++;
+        if (n <= 50) // Per-event lines only for small systems.
+            printf("P%d: %s\n", pid, result == 1 ? "GRANTED" : result == 0 ? "WAIT (not available)" :
+                   result == -1 ? "DENIED (unsafe)" : "ERROR (exceeds maximum claim)");
+    }
+    printf("\n%ld events in %.1f us: %ld granted, %ld wait, %ld unsafe, %ld errors", events, now_us() - start,
+           granted, waits, unsafe, errors);
+    printf("\nGrants verified by prefix recheck: %ld, partial search: %ld, full checks: %ld",
+           fastgrants, partialchecks, fullchecks);
+    free(v);
+}
+
+// Thread-safe allocator. Worker threads call banker_acquire() and
+// banker_release(); one mutex guards the Banker state and a request that is
+// unavailable or unsafe waits on a condition variable until a release.
+// Fast path: if after the grant the process could finish with what is left
+// (need - req <= available - req), running it first gives back at least the
+// old available, so the old safe order still works and no check is needed.
+// The stored sequence is then stale and the next slow check rebuilds it.
+struct {
+    pthread_mutex_t lock;
+    pthread_cond_t released; // Signalled whenever units go back to the pool.
+    int *available;
+    int fastpath; // 1 to try the O(m) fast path first.
+    long grants, fast, slow, waits; // Counted under the lock.
+    double holdus, maxholdus, checkus, waitus; // Lock hold, safety-check and blocked time.
+} alloc;
+
+// Acquire req for pid, blocking until it can be granted safely. Returns 0 on
+// success, -1 if the request exceeds the process's maximum claim.
+int banker_acquire(int pid, int req[m]) {
+    int j, r, blocked = 0;
+    double t0 = now_us(), t1, t2;
+    pthread_mutex_lock(&alloc.lock);
+    while (1) {
+        t1 = now_us();
+        if (alloc.fastpath) {
+            for (j = 0; j < m && req[j] <= alloc.available[j] &&
+                        p[pid].need[j] <= alloc.available[j]; j++)
+                ;
+            if (j == m) { // Trivially safe: pid can run to completion now.
+                applyrequest(pid, req, alloc.available, 1);
+                havesequence = 0;
+                alloc.fast++;
+                break;
+            }
+        }
+        r = requestresources(pid, req, alloc.available);
+        t2 = now_us();
+        alloc.checkus += t2 - t1;
+        alloc.slow++;
+        if (r == 1) break;
+        if (r == -2) {
+            pthread_mutex_unlock(&alloc.lock);
+            return -1;
+        }
+        alloc.holdus += t2 - t1; // Count the failed check as hold time too.
+        blocked = 1;
+        pthread_cond_wait(&alloc.released, &alloc.lock);
+    }
+    t2 = now_us();
+    alloc.grants++;
+    alloc.holdus += t2 - t1;
+    if (t2 - t1 > alloc.maxholdus) alloc.maxholdus = t2 - t1;
+    if (blocked) {
+        alloc.waits++;
+        alloc.waitus += t1 - t0; // Time until the final, successful attempt.
+    }
+    pthread_mutex_unlock(&alloc.lock);
+    return 0;
+}
+
+// Give back everything pid holds (all = 1) or the units in rel.
+void banker_release(int pid, int rel[m], int all) {
+    int j;
+    pthread_mutex_lock(&alloc.lock);
+    double t1 = now_us();
+    if (all)
+        for (j = 0; j < m; j++)
+            rel[j] = p[pid].allocate[j];
+    if (havesequence)
+        releaseresources(pid, rel, alloc.available);
+    else
+        applyrequest(pid, rel, alloc.available, -1); // State stays safe; sequence is rebuilt lazily.
+    alloc.holdus += now_us() - t1;
+    pthread_cond_broadcast(&alloc.released);
+    pthread_mutex_unlock(&alloc.lock);
+}
+
+int workeriters; // Acquire/release rounds per worker.
+double workerholdus; // Time a worker uses its resources before releasing.
+
+// Worker thread driving process pid.
+void *allocworker(void *arg) {
+    int pid = (int)(long)arg, it, j, any;
+    unsigned seed = pid + 1;
+    int *v = malloc(m * sizeof(int));
+    for (it = 0; it < workeriters; it++) {
+        any = 0;
+        pthread_mutex_lock(&alloc.lock); // need[] changes under the lock.
+        for (j = 0; j < m; j++) {
+            v[j] = p[pid].need[j] ? rand_r(&seed) % (p[pid].need[j] + 1) : 0;
+            any |= v[j];
+        }
+        pthread_mutex_unlock(&alloc.lock);
+        if (any)
+            banker_acquire(pid, v);
+        double until = now_us() + workerholdus;
+        while (now_us() < until)
+            ; // Use the resources.
+        if (!any || rand_r(&seed) % 2)
+            banker_release(pid, v, 1); // Finished this piece of work.
+    }
+    banker_release(pid, v, 1);
+    free(v);
+    return NULL;
+}
+
+// Run the allocator with 1, 2, 4, ... worker threads, thread i driving Pi.
+// A process nobody drives would never release and could be the one every
+// safe sequence waits for, so each run first returns the units of Pt..Pn-1
+// to the pool (as if they had finished) and only P0..Pt-1 take part. The
+// state stays safe: the old safe order restricted to P0..Pt-1 still works
+// with the larger pool.
+void allocatorservice(int available[m]) {
+    int maxthreads, t, i, j;
+    printf("\nEnter max worker threads (at most %d), iterations per thread and hold time in us\n", n);
+    scanf("%d %d %lf", &maxthreads, &workeriters, &workerholdus);
+    printf("Enter 1 to enable the trivially-safe fast path, 0 to always run the check\n");
+    scanf("%d", &alloc.fastpath);
+    if (maxthreads > n) maxthreads = n;
+    if (maxthreads < 1) return;
+    int *savedavail = malloc(m * sizeof(int)), *saved = malloc((long)n * m * sizeof(int));
+
+    for (j = 0; j < m; j++) savedavail[j] = available[j];
+    for (i = 0; i < n; i++)
+        for (j = 0; j < m; j++) saved[i * m + j] = p[i].allocate[j];
+    pthread_mutex_init(&alloc.lock, NULL);
+    pthread_cond_init(&alloc.released, NULL);
+    alloc.available = available;
+
+    buildsequence(available); // Sizes seq[] and work[] for all n processes.
+    int alln = n;
+
+    printf("\nThreads\tGrants/s\tFast %%\tAvg hold us\tMax hold us\tCheck us\tLock busy %%\tBlocked\tAvg wait us\n");
+    for (t = 1; t <= maxthreads; t = (t * 2 > maxthreads && t < maxthreads) ? maxthreads : t * 2) {
+        pthread_t *tid = malloc(t * sizeof(pthread_t));
+        alloc.grants = alloc.fast = alloc.slow = alloc.waits = 0;
+        alloc.holdus = alloc.maxholdus = alloc.checkus = alloc.waitus = 0;
+        for (i = t; i < alln; i++) // Undriven processes finish and give back their units.
+            for (j = 0; j < m; j++) {
+                available[j] += p[i].allocate[j];
+                p[i].allocate[j] = 0;
+            }
+        n = t; // Only driven processes take part.
+        if (!buildsequence(available)) { // Only if the entered state itself is unsafe.
+            printf("%d\tstarting state for P0..P%d is unsafe\n", t, t - 1);
+        } else {
+            double start = now_us();
+            for (i = 0; i < t; i++) pthread_create(&tid[i], NULL, allocworker, (void *)(long)i);
+            for (i = 0; i < t; i++) pthread_join(tid[i], NULL);
+            double elapsed = now_us() - start;
+            printf("%d\t%.0f\t\t%.1f\t%.2f\t\t%.2f\t\t%.2f\t\t%.1f\t\t%ld\t%.1f\n", t, alloc.grants * 1e6 / elapsed,
+                   alloc.grants ? 100.0 * alloc.fast / alloc.grants : 0, alloc.grants ? alloc.holdus / alloc.grants : 0,
+                   alloc.maxholdus, alloc.slow ? alloc.checkus / alloc.slow : 0, 100 * alloc.holdus / elapsed,
+                   alloc.waits, alloc.waits ? alloc.waitus / alloc.waits : 0);
+        }
+        free(tid);
+        n = alln;
+
+        // Restore the entered state for the next run.
+        for (j = 0; j < m; j++) available[j] = savedavail[j];
+        for (i = 0; i < n; i++)
+            for (j = 0; j < m; j++) {
+                p[i].allocate[j] = saved[i * m + j];
+                p[i].need[j] = p[i].max[j] - p[i].allocate[j];
+            }
+    }
+    pthread_mutex_destroy(&alloc.lock);
+    pthread_cond_destroy(&alloc.released);
+    free(savedavail);
+    free(saved);
+}
+
+// Deadlock detection. Node i < n is process Pi and node n + j is resource Rj.
+// Pi -> Rj when Pi's pending request for Rj exceeds what is available, and
+// Rj -> Pk when Pk holds units of Rj. A deadlock needs a cycle, so only
+// processes inside a strongly connected component with more than one node can
+// be deadlocked; Tarjan's algorithm finds the components in O(V + E) with
+// V = n + m and E <= 2*n*m. With several units per resource a cycle is not
+// enough, so the reduction over request[] (same code as the sorted safety
+// check) decides which of those processes really cannot finish.
+int *adjstart, *adj; // Graph in compressed rows: edges of node v are adj[adjstart[v]..adjstart[v+1]-1].
+int *tindex, *tlow, *tstack, *onstack, *comp; // Tarjan state; comp[v] is v's component.
+int tcounter, tsp, ncomp;
+
+void strongconnect(int v) {
+    int e, w;
+    tindex[v] = tlow[v] = tcounter++;
+    tstack[tsp++] = v;
+    onstack[v] = 1;
+    for (e = adjstart[v]; e < adjstart[v + 1]; e++) {
+        w = adj[e];
+        if (tindex[w] < 0) { // Unvisited: recurse.
+            strongconnect(w);
+            if (tlow[w] < tlow[v]) tlow[v] = tlow[w];
+        } else if (onstack[w] && tindex[w] < tlow[v]) {
+            tlow[v] = tindex[w]; // Back edge into the current component.
+        }
+    }
+    if (tlow[v] == tindex[v]) { // v is the root of a component: pop it.
+        do {
+            w = tstack[--tsp];
+            onstack[w] = 0;
+            comp[w] = ncomp;
+        } while (w != v);
+        ncomp++;
+    }
+}
+
+// Mark deadlocked processes in dead[] for the given available vector and
+// return how many there are: processes that cannot finish in the reduction,
+// hold something, and sit on a cycle. (A process whose request can never be
+// met, with no cycle involved, is an invalid request rather than a deadlock.)
+int *compsize; // Nodes in each component.
+
+int finddeadlocked(int available[m], int dead[n]) {
+    int i, j, k, count = 0, *order = malloc(n * sizeof(int));
+    k = reduction(available, order, 1);
+    for (i = 0; i < n; i++)
+        dead[i] = 1;
+    for (i = 0; i < k; i++)
+        dead[order[i]] = 0; // Its request can be met eventually.
+    for (i = 0; i < n; i++) {
+        for (j = 0; j < m && p[i].allocate[j] == 0; j++)
+            ;
+        if (j == m || compsize[comp[i]] < 2) dead[i] = 0;
+        count += dead[i];
+    }
+    free(order);
+    return count;
+}
+
+// Take pid out of the system (sign 1) or put it back (sign -1). Its units go
+// to w[] and saved[] keeps its rows so the abort can be undone.
+void abortprocess(int pid, int w[m], int saved[], int sign) {
+    int j;
+    for (j = 0; j < m; j++) {
+        if (sign == 1) {
+            saved[j] = p[pid].allocate[j];
+            saved[m + j] = p[pid].request[j];
+            w[j] += saved[j];
+            p[pid].allocate[j] = p[pid].request[j] = 0;
+        } else {
+            p[pid].allocate[j] = saved[j];
+            p[pid].request[j] = saved[m + j];
+            w[j] -= saved[j];
+        }
+    }
+}
+
+void detectdeadlock(int available[m]) {
+    int i, j, v, c, total = n + m, edges = 0, usecost, ndead;
+    int *cost = malloc(n * sizeof(int)), *dead = malloc(n * sizeof(int)), *trial = malloc(n * sizeof(int));
+    int *w = malloc(m * sizeof(int)), *aborted = calloc(n, sizeof(int));
+    int *saved = malloc((long)n * 2 * m * sizeof(int)); // Rows of aborted processes.
+
+    printf("\nEnter the pending request of each process (%d values per process)\n", m);
+    for (i = 0; i < n; i++)
+        for (j = 0; j < m; j++)
+            scanf("%d", &p[i].request[j]);
+    printf("Enter 1 to give an abort cost per process, 0 to use the units it holds\n");
+    scanf("%d", &usecost);
+    for (i = 0; i < n; i++) {
+        if (usecost) {
+            scanf("%d", &cost[i]);
+        } else {
+            for (cost[i] = 0, j = 0; j < m; j++)
+                cost[i] += p[i].allocate[j];
+        }
+    }
+    double start = now_us();
+
+    // Build the resource-allocation graph.
+    adjstart = calloc(total + 1, sizeof(int));
+    for (i = 0; i < n; i++)
+        for (j = 0; j < m; j++) {
+            if (p[i].request[j] > available[j]) adjstart[i + 1]++; // Pi waits for Rj.
+            if (p[i].allocate[j] > 0) adjstart[n + j + 1]++; // Rj is held by Pi.
+        }
+    for (v = 0; v < total; v++)
+        adjstart[v + 1] += adjstart[v];
+    edges = adjstart[total];
+    adj = malloc((edges + 1) * sizeof(int));
+    int *fill = malloc(total * sizeof(int));
+    for (v = 0; v < total; v++)
+        fill[v] = adjstart[v];
+    for (i = 0; i < n; i++)
+        for (j = 0; j < m; j++) {
+            if (p[i].request[j] > available[j]) adj[fill[i]++] = n + j;
+            if (p[i].allocate[j] > 0) adj[fill[n + j]++] = i;
+        }
+
+    // Strongly connected components.
+    tindex = malloc(total * sizeof(int));
+    tlow = malloc(total * sizeof(int));
+    tstack = malloc(total * sizeof(int));
+    onstack = calloc(total, sizeof(int));
+    comp = malloc(total * sizeof(int));
+    tcounter = tsp = ncomp = 0;
+    for (v = 0; v < total; v++)
+        tindex[v] = -1;
+    for (v = 0; v < total; v++)
+        if (tindex[v] < 0) strongconnect(v);
+
+    int cyclic = 0;
+    compsize = calloc(ncomp, sizeof(int));
+    for (v = 0; v < total; v++)
+        compsize[comp[v]]++;
+    for (c = 0; c < ncomp; c++)
+        cyclic += compsize[c] > 1;
+
+    for (j = 0; j < m; j++)
+        w[j] = available[j];
+    ndead = finddeadlocked(w, dead);
+    printf("\nGraph: %d nodes, %d edges, %d cyclic components", total, edges, cyclic);
+    if (ndead == 0)
+        printf("\nNO DEADLOCK");
+
+    // Report each deadlocked set (deadlocked processes sharing a component).
+    for (c = 0; c < ncomp && ndead > 0; c++) {
+        int found = 0;
+        for (i = 0; i < n; i++) {
+            if (dead[i] && comp[i] == c) {
+                if (!found) printf("\nDeadlocked set:");
+                printf(" P%d", i);
+                found = 1;
+            }
+        }
+        if (found) {
+            printf(" (waiting on");
+            for (j = 0; j < m; j++)
+                if (comp[n + j] == c) printf(" R%d", j);
+            printf(")");
+        }
+    }
+
+    // Recovery plan: the cheapest single abort that clears every deadlock if
+    // there is one, otherwise abort the cheapest deadlocked process and repeat.
+    while (ndead > 0) {
+        int best = -1, cheapest = -1;
+        for (i = 0; i < n; i++) {
+            if (!dead[i]) continue;
+            if (cheapest < 0 || cost[i] < cost[cheapest]) cheapest = i;
+            if (best >= 0 && cost[i] >= cost[best]) continue; // Cannot beat it.
+            abortprocess(i, w, &saved[(long)i * 2 * m], 1);
+            if (finddeadlocked(w, trial) == 0) best = i;
+            abortprocess(i, w, &saved[(long)i * 2 * m], -1);
+        }
+        if (best < 0) best = cheapest;
+        abortprocess(best, w, &saved[(long)best * 2 * m], 1);
+        aborted[best] = 1;
+        ndead = finddeadlocked(w, dead);
+        printf("\nVictim: abort P%d (cost %d) -> %d deadlocked left", best, cost[best], ndead);
+    }
+    for (i = 0; i < n; i++) // Only a plan: put aborted processes back.
+        if (aborted[i]) abortprocess(i, w, &saved[(long)i * 2 * m], -1);
+    printf("\nDetection and recovery plan took %.1f us", now_us() - start);
+
+    free(adjstart); free(adj); free(fill);
+    free(tindex); free(tlow); free(tstack); free(onstack); free(comp); free(compsize);
+    free(cost); free(dead); free(trial); free(w); free(aborted); free(saved);
+}
+
+// All safe sequences. The work available after a set S of processes has
+// finished is available + sum of their allocations, whatever order they ran
+// in, so the number of ways to finish from S depends only on the bitmask S and
+// is memoised in seqmemo[S]. Worker threads split the search by its first two
+// steps and share the table; two threads may fill the same entry, but they
+// store the same value. Counts are doubles: exact up to 2^53, approximate above.
+#define MAXENUM 25 // 2^25 memo entries (256 MB of address space, touched lazily).
+
+_Atomic double *seqmemo; // 1 + safe completions from finished set S; 0 = not computed.
+unsigned fullset; // Bitmask with all n processes finished.
+_Atomic int nexttask; // Next (first, second) pair for a worker to take.
+_Atomic long statesvisited; // Memo entries computed.
+
+// Can process i run with work w[]?
+int canrun(int i, int w[m]) {
+    int j;
+    for (j = 0; j < m && p[i].need[j] <= w[j]; j++)
+        ;
+    return j == m;
+}
+
+double countfrom(unsigned S, int w[m]) {
+    int i, j, nw[m];
+    double c, total = 0;
+    if (S == fullset) return 1;
+    c = atomic_load_explicit(&seqmemo[S], memory_order_relaxed);
+    if (c > 0) return c - 1;
+    for (i = 0; i < n; i++) {
+        if ((S >> i & 1) || !canrun(i, w)) continue;
+        for (j = 0; j < m; j++)
+            nw[j] = w[j] + p[i].allocate[j];
+        total += countfrom(S | 1u << i, nw);
+    }
+    atomic_store_explicit(&seqmemo[S], total + 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&statesvisited, 1, memory_order_relaxed);
+    return total;
+}
+
+int *enumavail; // Available vector for the workers.
+
+// Worker: take (first, second) pairs until none are left.
+void *enumworker(void *arg) {
+    int t, a, b, j, w[m];
+    (void)arg;
+    while ((t = atomic_fetch_add(&nexttask, 1)) < n * n) {
+        a = t / n;
+        b = t % n;
+        if (a == b) continue;
+        for (j = 0; j < m; j++) w[j] = enumavail[j];
+        if (!canrun(a, w)) continue;
+        for (j = 0; j < m; j++) w[j] += p[a].allocate[j];
+        if (!canrun(b, w)) continue;
+        for (j = 0; j < m; j++) w[j] += p[b].allocate[j];
+        countfrom(1u << a | 1u << b, w);
+    }
+    return NULL;
+}
+
+// Print up to *left safe sequences that start with seqbuf[0..depth-1].
+void listsequences(unsigned S, int w[m], int seqbuf[], int depth, long *left) {
+    int i, j, nw[m];
+    if (*left <= 0) return;
+    if (S == fullset) {
+        printf("\n");
+        for (i = 0; i < n; i++) printf("P%d -> ", seqbuf[i]);
+        (*left)--;
+        return;
+    }
+    for (i = 0; i < n && *left > 0; i++) {
+        if ((S >> i & 1) || !canrun(i, w)) continue;
+        for (j = 0; j < m; j++) nw[j] = w[j] + p[i].allocate[j];
+        if (countfrom(S | 1u << i, nw) == 0) continue; // Dead end: prune.
+        seqbuf[depth] = i;
+        listsequences(S | 1u << i, nw, seqbuf, depth + 1, left);
+    }
+}
+
+int *enumcost; // Cost of each process for the best sequence.
+
+int bycost(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    if (enumcost[x] != enumcost[y]) return enumcost[x] - enumcost[y];
+    return x - y;
+}
+
+void enumeratesequences(int available[m]) {
+    int i, j, t, threads, *w = malloc(m * sizeof(int)), *seqbuf = malloc(n * sizeof(int));
+    int *rank = malloc(n * sizeof(int));
+    long show;
+    if (n > MAXENUM) {
+        printf("\nEnumeration supports at most %d processes", MAXENUM);
+        free(w); free(seqbuf); free(rank);
+        return;
+    }
+    enumcost = malloc(n * sizeof(int));
+    printf("\nEnter number of worker threads\n");
+    scanf("%d", &threads);
+    if (threads < 1) threads = 1;
+    printf("Enter the cost of each process (best sequence runs cheaper processes first)\n");
+    for (i = 0; i < n; i++)
+        scanf("%d", &enumcost[i]);
+    printf("Enter how many safe sequences to list (0 for none)\n");
+    scanf("%ld", &show);
+
+    double start = now_us();
+    fullset = (1u << n) - 1;
+    seqmemo = calloc((size_t)1 << n, sizeof(double));
+    enumavail = available;
+    atomic_store(&nexttask, 0);
+    atomic_store(&statesvisited, 0);
+    pthread_t *tid = malloc(threads * sizeof(pthread_t));
+    if (n >= 2) {
+        for (t = 0; t < threads; t++) pthread_create(&tid[t], NULL, enumworker, NULL);
+        for (t = 0; t < threads; t++) pthread_join(tid[t], NULL);
+    }
+    for (j = 0; j < m; j++) w[j] = available[j];
+    double count = countfrom(0, w); // Combines the pairs the workers filled in.
+    double elapsed = now_us() - start;
+
+    printf("\nSafe sequences: %.0f%s", count, count > 9007199254740992.0 ? " (approximate)" : "");
+    printf("\nStates evaluated: %ld of %.0f, %d threads, %.1f us", atomic_load(&statesvisited),
+           (double)((size_t)1 << n), threads, elapsed);
+
+    if (count > 0) {
+        // Best sequence: at each step the cheapest process that still leads to completion.
+        unsigned S = 0;
+        for (i = 0; i < n; i++) rank[i] = i;
+        qsort(rank, n, sizeof(int), bycost);
+        printf("\nBest sequence by cost: ");
+        for (int step = 0; step < n; step++) {
+            for (t = 0; t < n; t++) {
+                i = rank[t];
+                if ((S >> i & 1) || !canrun(i, w)) continue;
+                for (j = 0; j < m; j++) w[j] += p[i].allocate[j];
+                if (countfrom(S | 1u << i, w) > 0) break;
+                for (j = 0; j < m; j++) w[j] -= p[i].allocate[j]; // Dead end: undo.
+            }
+            S |= 1u << i;
+            printf("P%d -> ", i);
+        }
+        for (j = 0; j < m; j++) w[j] = available[j];
+        listsequences(0, w, seqbuf, 0, &show);
+    }
+    free(seqmemo);
+    free(tid);
+    free(w);
+    free(seqbuf);
+    free(rank);
+    free(enumcost);
+}
+
 /*
 // Explanation of Specific Keywords and Libraries
 #include: Preprocessor directive to include standard libraries for input/output functions.
@@ -3,6 +3,7 @@
 #include<semaphore.h>
 #include<pthread.h>
 #include<sys/syscall.h>
+#include<sched.h>
 
 void *reader(void *argp);
 void *writer(void *argp);
@@ -45,13 +46,20 @@ return 0;
 void*  writer(void *argp) {
 
 	while(1) {
-	
-		pthread_mutex_lock(&wrt);
-		if(flag==0) {
-			buffer=getbuff();
-			flag=1;
+		int item=getbuff();
+		int stored=0;
+
+		while(!stored) {
+			pthread_mutex_lock(&wrt);
+			if(flag==0) {
+				buffer=item;
+				flag=1;
+				stored=1;
+			}
+			pthread_mutex_unlock(&wrt);
+			if(!stored)
+				sched_yield();
 		}
-		pthread_mutex_unlock(&wrt);
 	}
 }
 
@@ -66,12 +74,11 @@ void* reader(void *argp) {
 		}
 		pthread_mutex_unlock(&mutex1);
 
-		
+		int item=0,got=0;
 		if(flag==1){
-			readbuff(buffer);	
-			sleep(1);
+			item=buffer;
 			flag=0;
-		
+			got=1;
 		}
 		pthread_mutex_lock(&mutex1);
 		read_count--;
@@ -81,6 +88,11 @@ void* reader(void *argp) {
 		
 		}
 		pthread_mutex_unlock(&mutex1);
+
+		if(got){
+			readbuff(item);
+			sleep(1);
+		}
 	}
 
 }
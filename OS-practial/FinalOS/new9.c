@@ -1,3 +1,4 @@
+#define _GNU_SOURCE    // splice, vmsplice, F_SETPIPE_SZ
 #include <sys/types.h> // Required for mkfifo
 #include <sys/stat.h>  // Required for mkfifo
 #include <stdio.h>
@@ -5,26 +6,102 @@
 #include <string.h>
 #include <unistd.h>
 #include <sys/wait.h>
+#include <sys/uio.h>   // struct iovec for vmsplice
+#include <sys/mman.h>  // mmap the input in shard mode
+#include <sys/file.h>  // flock on the shared request FIFO in server mode
+#include <limits.h>    // PIPE_BUF
+#include <poll.h>
+#include <pthread.h>   // Worker pool in server mode
+#include <sys/epoll.h>
+#include <sys/resource.h> // Raise the open-file limit in epoll mode
+#include <signal.h>
 #include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <stdint.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h> // Byte compares and movemask for the vectorised counter.
+#endif
 #define FIFO1 "/tmp/fifo1"
 #define FIFO2 "/tmp/fifo2"
+#define CHUNK (1 << 20) // Bytes moved per syscall in stream mode.
 
-void count_and_write(const char *sentence) {
-    int characters = 0, words = 0, lines = 0, inWord = 0;
-    for (const char *p = sentence; *p; p++) {
-        characters++;
+// Running totals, so text can be counted a chunk at a time.
+typedef struct {
+    long characters, words, lines;
+    int inWord;            // The last byte seen was inside a word.
+} textstats;
+
+void count_chunk(textstats *st, const char *p, size_t n) {
+    for (const char *end = p + n; p < end; p++) {
         if (*p == ' ' || *p == '\n') {
-            if (inWord) { words++; inWord = 0; }
-            if (*p == '\n') lines++;
+            if (st->inWord) { st->words++; st->inWord = 0; }
+            if (*p == '\n') st->lines++;
         } else {
-            inWord = 1;
+            st->inWord = 1;
+        }
+    }
+    st->characters += n;
+}
+
+// Vectorised count_chunk: 64 bytes per step. The block is compared against
+// ' ' and '\n' and turned into bit masks (bit i = byte i); lines are the
+// popcount of the newline mask, and a word starts wherever a non-separator
+// follows a separator, so starts = popcount(~sep & (sep << 1 | carry)),
+// where carry is whether the byte before the block was a separator. The
+// tail, and builds without SSE2/AVX2, use the scalar loop.
+void count_chunk_simd(textstats *st, const char *p, size_t n) {
+#if defined(__AVX2__) || defined(__SSE2__)
+    uint64_t carry = !st->inWord, sep, nl;
+    long starts = 0, lines = 0;
+    size_t i;
+    for (i = 0; i + 64 <= n; i += 64) {
+#if defined(__AVX2__)
+        const __m256i space = _mm256_set1_epi8(' '), newline = _mm256_set1_epi8('\n');
+        __m256i a = _mm256_loadu_si256((const __m256i *)(p + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(p + i + 32));
+        __m256i na = _mm256_cmpeq_epi8(a, newline), nb = _mm256_cmpeq_epi8(b, newline);
+        __m256i sa = _mm256_or_si256(na, _mm256_cmpeq_epi8(a, space));
+        __m256i sb = _mm256_or_si256(nb, _mm256_cmpeq_epi8(b, space));
+        nl = (uint32_t)_mm256_movemask_epi8(na) | (uint64_t)(uint32_t)_mm256_movemask_epi8(nb) << 32;
+        sep = (uint32_t)_mm256_movemask_epi8(sa) | (uint64_t)(uint32_t)_mm256_movemask_epi8(sb) << 32;
+#else
+        const __m128i space = _mm_set1_epi8(' '), newline = _mm_set1_epi8('\n');
+        nl = sep = 0;
+        for (int k = 0; k < 4; k++) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(p + i + 16 * k));
+            __m128i nv = _mm_cmpeq_epi8(v, newline);
+            nl |= (uint64_t)_mm_movemask_epi8(nv) << (16 * k);
+            sep |= (uint64_t)_mm_movemask_epi8(_mm_or_si128(nv, _mm_cmpeq_epi8(v, space))) << (16 * k);
         }
+#endif
+        starts += __builtin_popcountll(~sep & (sep << 1 | carry));
+        lines += __builtin_popcountll(nl);
+        carry = sep >> 63;
     }
-    if (inWord) words++;
+    int inWord = !carry;
+    st->words += starts + st->inWord - inWord; // Words opened before or in here, minus the one still open.
+    st->inWord = inWord;
+    st->lines += lines;
+    st->characters += i;
+    p += i;
+    n -= i;
+#endif
+    count_chunk(st, p, n);
+}
+
+// Words still open at the end of the text count too.
+long total_words(const textstats *st) {
+    return st->words + st->inWord;
+}
+
+void count_and_write(const char *sentence) {
+    textstats st = {0};
+    count_chunk(&st, sentence, strlen(sentence));
 
     FILE *fp = fopen("output.txt", "w");
     if (fp) {
-        fprintf(fp, "Characters: %d\nWords: %d\nLines: %d\n", characters, words, lines);
+        fprintf(fp, "Characters: %ld\nWords: %ld\nLines: %ld\n", st.characters, total_words(&st), st.lines);
         fclose(fp);
     } else {
         perror("Failed to open file");
@@ -72,12 +149,820 @@ void parent_process() {
     close(fd2);
 }
 
-int main() {
+double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Stream mode: any amount of text from stdin (./a.out stream < big.txt).
+// The parent splices stdin straight into FIFO1, so the text never passes
+// through its memory; the child counts it in CHUNK-sized reads, keeping the
+// state between chunks, and vmsplices the result into FIFO2. No temp file.
+void stream_child() {
+    static char result[128]; // Must stay untouched after vmsplice: it is not reused.
+    char *buf = malloc(CHUNK);
+    textstats st = {0};
+    long calls = 0;
+    ssize_t n;
+    int fd1 = open(FIFO1, O_RDONLY);
+    int fd2 = open(FIFO2, O_WRONLY);
+
+    while ((n = read(fd1, buf, CHUNK)) > 0) {
+        count_chunk_simd(&st, buf, n);
+        calls++;
+    }
+    int len = snprintf(result, sizeof(result), "Characters: %ld\nWords: %ld\nLines: %ld\nChild reads: %ld\n",
+                       st.characters, total_words(&st), st.lines, calls);
+    struct iovec iov = {result, len};
+    while (iov.iov_len > 0 && (n = vmsplice(fd2, &iov, 1, 0)) > 0) {
+        iov.iov_base = (char *)iov.iov_base + n;
+        iov.iov_len -= n;
+    }
+    free(buf);
+    close(fd1);
+    close(fd2);
+    exit(0);
+}
+
+int stream_parent() {
+    int fd1 = open(FIFO1, O_WRONLY);
+    int fd2 = open(FIFO2, O_RDONLY);
+    long total = 0, calls = 0;
+    ssize_t n;
+    char *buf = NULL;
+    double start = now_sec();
+
+    fcntl(fd1, F_SETPIPE_SZ, CHUNK); // Bigger pipe: fewer, larger transfers (best effort).
+    while ((n = splice(STDIN_FILENO, NULL, fd1, NULL, CHUNK, SPLICE_F_MOVE | SPLICE_F_MORE)) > 0) {
+        total += n;
+        calls++;
+    }
+    if (n < 0 && errno == EINVAL) { // stdin cannot be spliced (e.g. a terminal): copy instead.
+        buf = malloc(CHUNK);
+        while ((n = read(STDIN_FILENO, buf, CHUNK)) > 0) {
+            for (ssize_t off = 0, w; off < n; off += w)
+                if ((w = write(fd1, buf + off, n - off)) < 0) break;
+            total += n;
+            calls += 2;
+        }
+        free(buf);
+    }
+    if (n < 0) perror("stream");
+    close(fd1); // EOF for the child.
+
+    char result[256];
+    ssize_t len = 0;
+    while ((n = read(fd2, result + len, sizeof(result) - 1 - len)) > 0) len += n;
+    result[len] = '\0';
+    close(fd2);
+    wait(NULL);
+    double elapsed = now_sec() - start;
+
+    printf("Results received from child process:\n%s", result);
+    printf("Streamed %ld bytes in %.3f s (%.1f MB/s), parent transfer syscalls: %ld\n", total, elapsed,
+           total / elapsed / 1e6, calls);
+    return 0;
+}
+
+// Shard mode: ./a.out shard <workers> < big.txt. The input is cut into one
+// piece per worker, each cut moved forward to the next separator, and the
+// parent feeds every worker its piece over a pipe at the same time (poll on
+// non-blocking write ends, vmsplice from the mapped input). Each worker
+// counts its piece and sends back a textstats. Every cut lands on a
+// separator or at the end of the input, so no word straddles two pieces.
+#define MAX_WORKERS 64
+
+int is_separator(char c) {
+    return c == ' ' || c == '\n';
+}
+
+// The whole of stdin in memory: mapped if it is a file, read otherwise.
+char *load_input(size_t *size, int *mapped) {
+    struct stat sb;
+    if (fstat(STDIN_FILENO, &sb) == 0 && S_ISREG(sb.st_mode) && sb.st_size > 0) {
+        char *p = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, STDIN_FILENO, 0);
+        if (p != MAP_FAILED) {
+            *size = sb.st_size;
+            *mapped = 1;
+            return p;
+        }
+    }
+    size_t cap = CHUNK, len = 0;
+    char *buf = malloc(cap);
+    ssize_t n;
+    while ((n = read(STDIN_FILENO, buf + len, cap - len)) > 0) {
+        len += n;
+        if (len == cap) buf = realloc(buf, cap *= 2);
+    }
+    *size = len;
+    *mapped = 0;
+    return buf;
+}
+
+int shardmain(int argc, char *argv[]) {
+    int workers = argc > 2 ? atoi(argv[2]) : 4, i;
+    if (workers < 1 || workers > MAX_WORKERS) {
+        printf("usage: %s shard <workers 1-%d> < file\n", argv[0], MAX_WORKERS);
+        return 1;
+    }
+    size_t size, cut[MAX_WORKERS + 1], sent[MAX_WORKERS];
+    int mapped, data[MAX_WORKERS], results[MAX_WORKERS];
+    pid_t pid[MAX_WORKERS];
+    double start = now_sec();
+    char *text = load_input(&size, &mapped);
+    double loaded = now_sec();
+
+    cut[0] = 0;
+    cut[workers] = size;
+    for (i = 1; i < workers; i++) {
+        size_t c = size / workers * i;
+        if (c < cut[i - 1]) c = cut[i - 1];
+        while (c < size && !is_separator(text[c])) c++; // Do not cut through a word.
+        cut[i] = c;
+    }
+
+    for (i = 0; i < workers; i++) {
+        int in[2] = {-1, -1}, out[2] = {-1, -1};
+        if (pipe(in) < 0 || pipe(out) < 0 || (pid[i] = fork()) < 0) {
+            perror("shard");
+            close(in[0]); close(in[1]); close(out[0]); close(out[1]);
+            for (int j = 0; j < i; j++) { // EOF lets the workers already started finish.
+                close(data[j]);
+                close(results[j]);
+                waitpid(pid[j], NULL, 0);
+            }
+            if (mapped) munmap(text, size);
+            else free(text);
+            return 1;
+        }
+        if (pid[i] == 0) {
+            for (int j = 0; j < i; j++) { close(data[j]); close(results[j]); }
+            close(in[1]);
+            close(out[0]);
+            char *buf = malloc(CHUNK);
+            textstats st = {0};
+            ssize_t n;
+            while ((n = read(in[0], buf, CHUNK)) > 0) count_chunk_simd(&st, buf, n);
+            write(out[1], &st, sizeof(st));
+            exit(0);
+        }
+        close(in[0]);
+        close(out[1]);
+        fcntl(in[1], F_SETPIPE_SZ, CHUNK);
+        fcntl(in[1], F_SETFL, O_NONBLOCK);
+        data[i] = in[1];
+        results[i] = out[0];
+        sent[i] = 0;
+    }
+
+    int open_pipes = workers;
+    for (i = 0; i < workers; i++)
+        if (cut[i] == cut[i + 1]) { close(data[i]); data[i] = -1; open_pipes--; }
+    while (open_pipes > 0) { // Feed every worker as soon as its pipe has room.
+        struct pollfd pfd[MAX_WORKERS];
+        for (i = 0; i < workers; i++) {
+            pfd[i].fd = data[i];
+            pfd[i].events = POLLOUT;
+        }
+        poll(pfd, workers, -1);
+        for (i = 0; i < workers; i++) {
+            if (data[i] < 0 || !(pfd[i].revents & (POLLOUT | POLLERR))) continue;
+            size_t left = cut[i + 1] - cut[i] - sent[i];
+            struct iovec iov = {text + cut[i] + sent[i], left < CHUNK ? left : CHUNK};
+            ssize_t n = vmsplice(data[i], &iov, 1, SPLICE_F_NONBLOCK);
+            if (n < 0 && errno == EINVAL) n = write(data[i], iov.iov_base, iov.iov_len); // Not spliceable.
+            if (n > 0) sent[i] += n;
+            if (sent[i] == cut[i + 1] - cut[i] || (n < 0 && errno != EAGAIN)) {
+                close(data[i]); // EOF for the worker.
+                data[i] = -1;
+                open_pipes--;
+            }
+        }
+    }
+
+    textstats total = {0};
+    long words = 0;
+    for (i = 0; i < workers; i++) {
+        textstats st = {0};
+        read(results[i], &st, sizeof(st));
+        close(results[i]);
+        waitpid(pid[i], NULL, 0);
+        total.characters += st.characters;
+        total.lines += st.lines;
+        words += total_words(&st); // Cuts sit on separators, so no word spans two pieces.
+    }
+    total.words = words;
+    double elapsed = now_sec() - start;
+
+    printf("Characters: %ld\nWords: %ld\nLines: %ld\n", total.characters, total.words, total.lines);
+    printf("%d workers: %zu bytes in %.3f s (load %.3f s), %.1f MB/s\n", workers, size, elapsed, loaded - start,
+           size / elapsed / 1e6);
+    if (mapped) munmap(text, size);
+    else free(text);
+    return 0;
+}
+
+// ./a.out countbench [MB]: scalar vs vectorised counting over random text.
+int countbench(int argc, char *argv[]) {
+    size_t n = (size_t)(argc > 2 ? atol(argv[2]) : 256) << 20;
+    const char *pieces[] = {"the", " ", "quick", "  ", "\n", "brown", "fox", " \n", "jumps", "\n\n", "a"};
+    char *text = malloc(n);
+    unsigned rng = 12345;
+    size_t i = 0;
+    while (i < n) {
+        rng = rng * 1103515245 + 12345;
+        for (const char *w = pieces[(rng >> 16) % 11]; *w && i < n; w++) text[i++] = *w;
+    }
+    const char *name[] = {"scalar", "simd"};
+    textstats st[2];
+    double best[2];
+    for (int k = 0; k < 2; k++) {
+        best[k] = 1e9;
+        for (int rep = 0; rep < 3; rep++) {
+            textstats cur = {0};
+            double start = now_sec();
+            (k ? count_chunk_simd : count_chunk)(&cur, text, n);
+            double t = now_sec() - start;
+            if (t < best[k]) best[k] = t;
+            st[k] = cur;
+        }
+        printf("%-6s %8.3f s  %6.2f GB/s  characters %ld words %ld lines %ld\n", name[k], best[k],
+               n / best[k] / 1e9, st[k].characters, total_words(&st[k]), st[k].lines);
+    }
+#if defined(__AVX2__)
+    printf("kernel: AVX2, ");
+#elif defined(__SSE2__)
+    printf("kernel: SSE2, ");
+#else
+    printf("kernel: scalar only, ");
+#endif
+    printf("speedup %.1fx%s\n", best[0] / best[1],
+           memcmp(&st[0], &st[1], sizeof(textstats)) == 0 ? "" : "  MISMATCH");
+    free(text);
+    return 0;
+}
+
+// Server mode: ./a.out server <workers> keeps FIFO1 open and answers framed
+// requests until a client sends quit. A request is a frameheader followed by
+// len bytes of text; the response is a statsframe with the same id, so a
+// client can have many requests in flight and match the answers even when
+// workers finish out of order. Every client shares FIFO1, so a client holds
+// an flock on it while writing a frame too large to be written atomically,
+// and the header carries the client's pid: the answer goes to that client's
+// own response FIFO, /tmp/fifo_<pid>.resp. Workers are threads: one at a
+// time reads a whole request (readlock), then counts it in parallel with the
+// others. Responses are smaller than PIPE_BUF, so each write is atomic.
+#define MAX_FRAME (64 << 20)   // Largest request accepted.
+#define QUIT_ID 0xffffffffu    // A zero-length request with this id stops the server.
+#define RESP_CACHE 64          // Response FIFOs each server worker keeps open.
+
+typedef struct {
+    uint32_t len, id;
+    int32_t client;            // Sender's pid (server mode routes the answer by it).
+} frameheader;
+
+typedef struct {
+    frameheader h;             // len = sizeof the counts that follow.
+    int64_t characters, words, lines;
+} statsframe;
+
+int server_in;
+pthread_mutex_t readlock = PTHREAD_MUTEX_INITIALIZER;
+
+// Read exactly n bytes; 0 on EOF or error.
+int readfull(int fd, void *buf, size_t n) {
+    for (size_t got = 0; got < n;) {
+        ssize_t r = read(fd, (char *)buf + got, n - got);
+        if (r <= 0) return 0;
+        got += r;
+    }
+    return 1;
+}
+
+int writefull(int fd, const void *buf, size_t n) {
+    for (size_t done = 0; done < n;) {
+        ssize_t w = write(fd, (const char *)buf + done, n - done);
+        if (w <= 0) return 0;
+        done += w;
+    }
+    return 1;
+}
+
+void client_fifos(pid_t pid, char *req, char *resp) {
+    sprintf(req, "/tmp/fifo_%d.req", (int)pid);
+    sprintf(resp, "/tmp/fifo_%d.resp", (int)pid);
+}
+
+typedef struct {
+    int32_t pid;
+    int fd;                    // -1 when not open.
+} respfd;
+
+// Send resp to the client's response FIFO, opening it on first use. cache
+// belongs to one worker. A write that fails with EPIPE means that client has
+// left (and a new one may have its pid), so reopen by name once.
+void send_response(respfd cache[], const statsframe *resp, int32_t client) {
+    respfd *e = &cache[(uint32_t)client % RESP_CACHE];
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (e->fd < 0 || e->pid != client) {
+            char req[64], name[64];
+            if (e->fd >= 0) close(e->fd);
+            client_fifos(client, req, name);
+            e->pid = client;
+            e->fd = open(name, O_WRONLY | O_NONBLOCK); // Fails at once if the client is gone.
+            if (e->fd < 0) return;
+            fcntl(e->fd, F_SETFL, 0);
+        }
+        if (writefull(e->fd, resp, sizeof(*resp))) return;
+        close(e->fd);
+        e->fd = -1;
+    }
+}
+
+void *server_worker(void *arg) {
+    size_t cap = CHUNK;
+    char *buf = malloc(cap);
+    frameheader h;
+    respfd cache[RESP_CACHE];
+    (void)arg;
+    for (int i = 0; i < RESP_CACHE; i++) cache[i].fd = -1;
+    while (1) {
+        pthread_mutex_lock(&readlock);
+        int ok = readfull(server_in, &h, sizeof(h));
+        if (ok && h.len > MAX_FRAME) { // Cannot resync a stream with a bad length: stop.
+            fprintf(stderr, "server: request of %u bytes is too large\n", h.len);
+            ok = 0;
+        }
+        if (ok && h.len > cap) buf = realloc(buf, cap = h.len);
+        if (ok) ok = readfull(server_in, buf, h.len);
+        pthread_mutex_unlock(&readlock);
+        if (!ok || (h.len == 0 && h.id == QUIT_ID)) break;
+
+        textstats st = {0};
+        count_chunk_simd(&st, buf, h.len);
+        statsframe resp = {{sizeof(resp) - sizeof(frameheader), h.id, 0}, st.characters, total_words(&st),
+                           st.lines};
+        send_response(cache, &resp, h.client);
+    }
+    // Pass the quit on so every other worker stops too.
+    frameheader quit = {0, QUIT_ID, 0};
+    writefull(server_in, &quit, sizeof(quit));
+    for (int i = 0; i < RESP_CACHE; i++)
+        if (cache[i].fd >= 0) close(cache[i].fd);
+    free(buf);
+    return NULL;
+}
+
+int servermain(int argc, char *argv[]) {
+    int workers = argc > 2 ? atoi(argv[2]) : 4, i;
+    if (workers < 1) {
+        printf("usage: %s server <workers>\n", argv[0]);
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN); // A vanished client shows up as EPIPE instead.
+    mkfifo(FIFO1, 0666);
+    // O_RDWR: opening does not wait for a client, and clients coming and
+    // going never produce EOF.
+    server_in = open(FIFO1, O_RDWR);
+    if (server_in < 0) {
+        perror("server");
+        return 1;
+    }
+    printf("Serving on %s with %d workers\n", FIFO1, workers);
+    fflush(stdout);
+    pthread_t tid[workers];
+    for (i = 0; i < workers; i++)
+        pthread_create(&tid[i], NULL, server_worker, NULL);
+    for (i = 0; i < workers; i++)
+        pthread_join(tid[i], NULL);
+    close(server_in);
+    unlink(FIFO1);
+    return 0;
+}
+
+int compare_long(const void *a, const void *b) {
+    long x = *(const long *)a, y = *(const long *)b;
+    return (x > y) - (x < y);
+}
+
+long now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+// Send requests frames of size bytes of generated text over in, keeping up
+// to depth outstanding, and read the answers from out. shared says other
+// clients write to in too, so every frame is sent under an flock: exclusive
+// for a frame too large to be written atomically, shared for the rest (they
+// cannot interleave with each other, only with a large frame's pieces).
+// Each request's latency goes into latency[]; answers
+// that do not match a local count are added to *wrong. Returns how many
+// answers arrived.
+long run_client(int in, int out, int shared, long requests, long size, long depth, long latency[], long *wrong) {
+    long sent = 0, done = 0, i;
+    char *text = malloc(size + 1);
+    for (i = 0; i < size; i++) text[i] = "ab c\n"[(i * 7 + i / 3) % 5];
+    textstats want = {0};
+    count_chunk(&want, text, size);
+    long *sentat = malloc(requests * sizeof(long));
+    int lock = sizeof(frameheader) + size > PIPE_BUF ? LOCK_EX : LOCK_SH;
+
+    while (done < requests) {
+        if (sent < requests && sent - done < depth) {
+            frameheader h = {size, sent, getpid()}; // ids stay below requests, so never QUIT_ID.
+            struct iovec iov[2] = {{&h, sizeof(h)}, {text, size}};
+            sentat[sent++] = now_ns();
+            if (shared) flock(in, lock);
+            ssize_t w = writev(in, iov, 2); // Blocking pipe: all of it or an error.
+            if (shared) flock(in, LOCK_UN);
+            if (w < 0) break;
+            continue;
+        }
+        statsframe resp;
+        if (!readfull(out, &resp, sizeof(resp))) break;
+        if (resp.h.id >= (uint32_t)sent) continue;
+        latency[done++] = now_ns() - sentat[resp.h.id];
+        if (resp.characters != want.characters || resp.words != total_words(&want) || resp.lines != want.lines)
+            (*wrong)++;
+    }
+    free(sentat);
+    free(text);
+    return done;
+}
+
+void print_latency(long latency[], long n) {
+    qsort(latency, n, sizeof(long), compare_long);
+    if (n > 0)
+        printf("latency us: p50 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n", latency[n / 2] / 1e3,
+               latency[n * 99 / 100] / 1e3, latency[n * 999 / 1000] / 1e3, latency[n - 1] / 1e3);
+}
+
+// ./a.out client <requests> <bytes per request> [in flight]  |  ./a.out client quit
+// Sends generated text, keeping up to "in flight" requests outstanding, and
+// checks every answer against a local count.
+int clientmain(int argc, char *argv[]) {
+    int quit = argc > 2 && strcmp(argv[2], "quit") == 0;
+    long requests = argc > 2 ? atol(argv[2]) : 10000, size = argc > 3 ? atol(argv[3]) : 1024;
+    long depth = argc > 4 ? atol(argv[4]) : 16, wrong = 0;
+    int in = open(FIFO1, O_WRONLY | O_NONBLOCK); // Fails at once if no server is listening.
+    if (in < 0) {
+        perror("client: no server on " FIFO1);
+        return 1;
+    }
+    fcntl(in, F_SETFL, 0);
+    if (quit) {
+        frameheader h = {0, QUIT_ID, getpid()};
+        flock(in, LOCK_SH); // Atomic, but must not land inside another client's large frame.
+        writefull(in, &h, sizeof(h));
+        flock(in, LOCK_UN);
+        close(in);
+        return 0;
+    }
+    if (requests < 1 || requests >= QUIT_ID || size < 0 || size > MAX_FRAME || depth < 1) {
+        printf("usage: %s client <requests> <bytes per request> [in flight]\n       %s client quit\n", argv[0],
+               argv[0]);
+        return 1;
+    }
+    // Our own response FIFO. Read-write, so it never reads as EOF while the
+    // server has it closed, and the server's non-blocking open finds a reader.
+    char req[64], resp[64];
+    client_fifos(getpid(), req, resp);
+    mkfifo(resp, 0666);
+    int out = open(resp, O_RDWR);
+    long *latency = malloc(requests * sizeof(long));
+    double start = now_sec();
+    long done = run_client(in, out, 1, requests, size, depth, latency, &wrong);
+    double elapsed = now_sec() - start;
+    printf("%ld requests of %ld bytes, %ld in flight: %.3f s, %.0f requests/s%s\n", done, size, depth, elapsed,
+           done / elapsed, wrong ? "  WRONG ANSWERS" : "");
+    print_latency(latency, done);
+    free(latency);
+    close(in);
+    close(out);
+    unlink(resp);
+    return done == requests ? 0 : 1;
+}
+
+// Event-loop mode: ./a.out epoll. One thread serves any number of clients,
+// each with its own request/response FIFO pair, using epoll on non-blocking
+// FIFOs. A client makes /tmp/fifo_<pid>.req and .resp, opens the response
+// end for reading, and writes its pid to FIFO_REGISTER; the server then
+// opens both and adds them to the epoll set. The request FIFO is opened
+// read-write, so it never reads as EOF before the client has opened it; a
+// client that goes away is noticed through EPOLLERR on its response FIFO.
+// Requests and answers use the same frames as server mode. Answers that do
+// not fit in a full response pipe wait in the connection's pending buffer
+// until epoll reports the pipe writable again. A client the server cannot
+// take (out of file descriptors) gets a zero-length QUIT_ID frame on its
+// response FIFO instead, and a client gives up if neither an accept nor a
+// refusal comes within CONNECT_TIMEOUT_MS.
+#define FIFO_REGISTER "/tmp/fifo_register"
+#define MAX_FDS 4096
+#define CONNECT_TIMEOUT_MS 5000
+
+typedef struct {
+    int in, out;               // Client's request FIFO (read) and response FIFO (write).
+    char *buf;                 // Request bytes received but not yet answered.
+    size_t len, cap;
+    char *pending;             // Answers waiting for room in the response FIFO.
+    size_t plen, pcap;
+} conn;
+
+conn *conns[MAX_FDS];          // Both FIFOs of a connection map to it.
+int spare_fd = -1;             // Kept open so a refusal can still be sent at the fd limit.
+
+void close_conn(int ep, conn *c) {
+    epoll_ctl(ep, EPOLL_CTL_DEL, c->in, NULL);
+    epoll_ctl(ep, EPOLL_CTL_DEL, c->out, NULL);
+    conns[c->in] = conns[c->out] = NULL;
+    close(c->in);
+    close(c->out);
+    free(c->buf);
+    free(c->pending);
+    free(c);
+}
+
+// Write as much pending output as the pipe takes; watch for EPOLLOUT while
+// some is left. Returns 0 if the client is gone.
+int flush_conn(int ep, conn *c) {
+    size_t done = 0;
+    while (done < c->plen) {
+        ssize_t w = write(c->out, c->pending + done, c->plen - done);
+        if (w < 0) {
+            if (errno != EAGAIN) return 0;
+            break;
+        }
+        done += w;
+    }
+    memmove(c->pending, c->pending + done, c->plen - done);
+    c->plen -= done;
+    struct epoll_event ev = {c->plen ? EPOLLOUT : 0, {.fd = c->out}}; // EPOLLERR is always reported.
+    epoll_ctl(ep, EPOLL_CTL_MOD, c->out, &ev);
+    return 1;
+}
+
+// Read what the client sent and answer every complete request. Returns 0
+// when the connection should be closed, -1 on a quit request.
+int serve_conn(int ep, conn *c) {
+    int alive = 1;
+    while (1) {
+        if (c->len == c->cap) c->buf = realloc(c->buf, c->cap *= 2);
+        ssize_t n = read(c->in, c->buf + c->len, c->cap - c->len);
+        if (n > 0) {
+            c->len += n;
+            continue;
+        }
+        if (n == 0 || errno != EAGAIN) alive = 0;
+        break;
+    }
+    size_t at = 0;
+    frameheader h;
+    while (c->len - at >= sizeof(h)) {
+        memcpy(&h, c->buf + at, sizeof(h));
+        if (h.len == 0 && h.id == QUIT_ID) return -1;
+        if (h.len > MAX_FRAME) return 0;
+        if (c->len - at < sizeof(h) + h.len) {
+            if (c->cap < sizeof(h) + h.len) { // Make room for the rest of this frame.
+                memmove(c->buf, c->buf + at, c->len - at);
+                c->len -= at;
+                at = 0;
+                c->buf = realloc(c->buf, c->cap = sizeof(h) + h.len);
+            }
+            break;
+        }
+        textstats st = {0};
+        count_chunk_simd(&st, c->buf + at + sizeof(h), h.len);
+        statsframe resp = {{sizeof(resp) - sizeof(frameheader), h.id, 0}, st.characters, total_words(&st),
+                           st.lines};
+        if (c->plen + sizeof(resp) > c->pcap) c->pending = realloc(c->pending, c->pcap = 2 * c->pcap + sizeof(resp));
+        memcpy(c->pending + c->plen, &resp, sizeof(resp));
+        c->plen += sizeof(resp);
+        at += sizeof(h) + h.len;
+    }
+    memmove(c->buf, c->buf + at, c->len - at);
+    c->len -= at;
+    if (!flush_conn(ep, c)) return 0;
+    return alive;
+}
+
+// Tell a client we cannot serve it, using the spare descriptor if we are
+// at the limit.
+void refuse_client(const char *resp) {
+    frameheader no = {0, QUIT_ID, 0};
+    close(spare_fd);
+    int fd = open(resp, O_WRONLY | O_NONBLOCK);
+    if (fd >= 0) {
+        writefull(fd, &no, sizeof(no));
+        close(fd);
+    }
+    spare_fd = open("/dev/null", O_RDONLY);
+}
+
+// Returns 0 if the client was refused.
+int accept_client(int ep, pid_t pid) {
+    char req[64], resp[64];
+    client_fifos(pid, req, resp);
+    // Response end first: the client's open of the request FIFO succeeds as
+    // soon as we open it, and it must not then find a response FIFO with no
+    // writer (which reads as EOF).
+    int out = open(resp, O_WRONLY | O_NONBLOCK); // The client already has the read end open.
+    int in = out < 0 ? -1 : open(req, O_RDWR | O_NONBLOCK);
+    if (in < 0 || out < 0 || in >= MAX_FDS || out >= MAX_FDS) {
+        if (in >= 0) close(in);
+        if (out >= 0) close(out);
+        refuse_client(resp);
+        return 0;
+    }
+    conn *c = calloc(1, sizeof(conn));
+    c->in = in;
+    c->out = out;
+    c->buf = malloc(c->cap = 4096);
+    conns[in] = conns[out] = c;
+    struct epoll_event ev = {EPOLLIN, {.fd = in}}, evout = {0, {.fd = out}};
+    epoll_ctl(ep, EPOLL_CTL_ADD, in, &ev);
+    epoll_ctl(ep, EPOLL_CTL_ADD, out, &evout);
+    return 1;
+}
+
+int epollmain(int argc, char *argv[]) {
+    (void)argc;
+    (void)argv;
+    signal(SIGPIPE, SIG_IGN); // A vanished client shows up as EPIPE instead.
+    // Two descriptors per client: raise the soft limit as far as conns[] goes.
+    struct rlimit rl;
+    getrlimit(RLIMIT_NOFILE, &rl);
+    if (rl.rlim_cur < MAX_FDS) {
+        rl.rlim_cur = rl.rlim_max < MAX_FDS ? rl.rlim_max : MAX_FDS;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+    mkfifo(FIFO_REGISTER, 0666);
+    int reg = open(FIFO_REGISTER, O_RDWR | O_NONBLOCK), ep = epoll_create1(0), running = 1, clients = 0, i;
+    int refused = 0;
+    struct epoll_event ev = {EPOLLIN, {.fd = reg}}, events[64];
+    epoll_ctl(ep, EPOLL_CTL_ADD, reg, &ev);
+    spare_fd = open("/dev/null", O_RDONLY);
+    printf("Serving clients registered on %s (room for about %ld at once)\n", FIFO_REGISTER,
+           (long)(rl.rlim_cur < MAX_FDS ? rl.rlim_cur : MAX_FDS) / 2 - 4);
+    fflush(stdout);
+    while (running) {
+        int n = epoll_wait(ep, events, 64, -1);
+        for (i = 0; i < n && running; i++) {
+            int fd = events[i].data.fd;
+            if (fd == reg) {
+                int32_t pid;
+                while (read(reg, &pid, sizeof(pid)) == sizeof(pid)) { // Registrations are atomic writes.
+                    if (accept_client(ep, pid)) clients++;
+                    else refused++;
+                }
+                continue;
+            }
+            conn *c = conns[fd];
+            if (!c) continue; // Closed earlier in this batch.
+            int r;
+            if (fd == c->out) r = !(events[i].events & EPOLLERR) && flush_conn(ep, c); // ERR: client left.
+            else r = serve_conn(ep, c);
+            if (r < 0) running = 0;
+            else if (r == 0) close_conn(ep, c);
+        }
+    }
+    for (i = 0; i < MAX_FDS; i++)
+        if (conns[i]) close_conn(ep, conns[i]);
+    close(reg);
+    close(ep);
+    close(spare_fd);
+    unlink(FIFO_REGISTER);
+    printf("Served %d clients, refused %d\n", clients, refused);
+    return 0;
+}
+
+// Connect to the epoll server: make our FIFO pair and register. in and out
+// are the request (write) and response (read) ends. Returns 0 with errno
+// ENOENT (no server), ECONNREFUSED or ETIMEDOUT if there is no connection.
+int epoll_connect(int *in, int *out) {
+    char req[64], resp[64];
+    int32_t pid = getpid();
+    client_fifos(pid, req, resp);
+    mkfifo(req, 0666);
+    mkfifo(resp, 0666);
+    *out = open(resp, O_RDONLY | O_NONBLOCK); // Open first so the server's open does not fail.
+    int reg = open(FIFO_REGISTER, O_WRONLY | O_NONBLOCK);
+    if (reg < 0) {
+        close(*out);
+        unlink(req);
+        unlink(resp);
+        return 0;
+    }
+    writefull(reg, &pid, sizeof(pid));
+    close(reg);
+    // The open succeeds once the server has opened the read end; until then
+    // it fails with ENXIO. Meanwhile watch for a refusal on the response FIFO.
+    int err = ETIMEDOUT;
+    for (int waited = 0; waited < CONNECT_TIMEOUT_MS; waited++) {
+        if ((*in = open(req, O_WRONLY | O_NONBLOCK)) >= 0 || errno != ENXIO) {
+            err = errno;
+            break;
+        }
+        frameheader no;
+        if (read(*out, &no, sizeof(no)) == sizeof(no) && no.id == QUIT_ID) {
+            err = ECONNREFUSED;
+            break;
+        }
+        usleep(1000);
+    }
+    unlink(req); // Both sides have them open (or never will); the names are no longer needed.
+    unlink(resp);
+    if (*in < 0) {
+        close(*out);
+        errno = err;
+        return 0;
+    }
+    fcntl(*in, F_SETFL, 0);
+    fcntl(*out, F_SETFL, 0);
+    return 1;
+}
+
+// ./a.out epollclient <clients> <requests per client> <bytes per request> [in flight]
+// ./a.out epollclient quit
+// Forks that many client processes, runs them all at once against the epoll
+// server and reports overall requests/s and latency percentiles.
+int epollclientmain(int argc, char *argv[]) {
+    int in, out, i;
+    if (argc > 2 && strcmp(argv[2], "quit") == 0) {
+        if (!epoll_connect(&in, &out)) {
+            perror("epollclient: cannot connect on " FIFO_REGISTER);
+            return 1;
+        }
+        frameheader h = {0, QUIT_ID, getpid()};
+        writefull(in, &h, sizeof(h));
+        close(in);
+        close(out);
+        return 0;
+    }
+    int clients = argc > 2 ? atoi(argv[2]) : 100;
+    long requests = argc > 3 ? atol(argv[3]) : 1000, size = argc > 4 ? atol(argv[4]) : 1024;
+    long depth = argc > 5 ? atol(argv[5]) : 4;
+    if (clients < 1 || requests < 1 || requests >= QUIT_ID || size < 0 || size > MAX_FRAME || depth < 1) {
+        printf("usage: %s epollclient <clients> <requests per client> <bytes per request> [in flight]\n"
+               "       %s epollclient quit\n", argv[0], argv[0]);
+        return 1;
+    }
+    // Shared with the children: per client, answers and wrong answers, then the latencies.
+    size_t bytes = (size_t)clients * (2 + requests) * sizeof(long);
+    long *shared = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    long *latency = shared + 2 * clients;
+    double start = now_sec();
+    for (i = 0; i < clients; i++) {
+        if (fork() == 0) {
+            if (!epoll_connect(&in, &out)) {
+                perror("epollclient: cannot connect on " FIFO_REGISTER);
+                exit(1);
+            }
+            shared[2 * i] = run_client(in, out, 0, requests, size, depth, latency + i * requests, &shared[2 * i + 1]);
+            exit(0);
+        }
+    }
+    for (i = 0; i < clients; i++)
+        wait(NULL);
+    double elapsed = now_sec() - start;
+    long done = 0, wrong = 0;
+    for (i = 0; i < clients; i++) { // Pack the latencies that were filled in.
+        memmove(latency + done, latency + i * requests, shared[2 * i] * sizeof(long));
+        done += shared[2 * i];
+        wrong += shared[2 * i + 1];
+    }
+    printf("%d clients x %ld requests of %ld bytes, %ld in flight each: %.3f s, %.0f requests/s%s\n", clients,
+           requests, size, depth, elapsed, done / elapsed, wrong ? "  WRONG ANSWERS" : "");
+    if (done < (long)clients * requests) printf("only %ld of %ld answered\n", done, (long)clients * requests);
+    print_latency(latency, done);
+    munmap(shared, bytes);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1 && strcmp(argv[1], "countbench") == 0)
+        return countbench(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "shard") == 0)
+        return shardmain(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "server") == 0)
+        return servermain(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "client") == 0)
+        return clientmain(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "epoll") == 0)
+        return epollmain(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "epollclient") == 0)
+        return epollclientmain(argc, argv);
+
+    int stream = argc > 1 && strcmp(argv[1], "stream") == 0;
     mkfifo(FIFO1, 0666);
     mkfifo(FIFO2, 0666);
 
     if (fork() == 0) {
+        if (stream) stream_child();
         child_process();
+    } else if (stream) {
+        stream_parent();
     } else {
         parent_process();
     }
@@ -0,0 +1,286 @@
+// Shared-memory message queue used by the queue modes of 10a.c (producer side) and 10b.c
+// (consumer side). The whole queue lives in one System V segment: a header with the two
+// cursors, then a ring of fixed-size message slots.
+//   SHMQ_SPSC - one producer process, one consumer process: each side owns one cursor and
+//               only reads the other's (with acquire loads). No locks, no compare-and-swap.
+//   SHMQ_MPMC - any number of each (Vyukov's bounded queue): every slot carries a sequence
+//               number saying whose turn it is, and positions are claimed with a CAS.
+// Messages are written and read in place (shmq_reserve/shmq_commit, shmq_peek/shmq_release),
+// so the data never goes through the kernel or an extra buffer. A side that finds the queue
+// full or empty spins briefly and then sleeps on a futex in the segment; the other side only
+// makes the wake syscall when someone is sleeping.
+// A segment left behind by an interrupted run is recognised (shmq_stale), and
+// creating a new queue marks the old one dead before removing it, so a
+// consumer still attached to it notices instead of waiting forever.
+#ifndef SHMQUEUE_H
+#define SHMQUEUE_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <limits.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#define SHMQ_SPSC 0
+#define SHMQ_MPMC 1
+#define SHMQ_MAGIC 0x51554555u      // Marks a segment that holds an initialised queue.
+#define SHMQ_DEAD 0xdeadu           // Set on a segment that has been replaced by a new one.
+#define SHMQ_SPIN 200               // Failed attempts before sleeping on the futex.
+#define SHMQ_NAP 100000000L         // Longest futex sleep (ns) between staleness checks.
+#define SHMQ_LINE 64
+
+typedef struct {
+    _Atomic uint32_t epoch;         // Futex word; bumped to wake sleepers.
+    _Atomic uint32_t waiters;       // Processes sleeping (or about to) on epoch.
+} shmq_waitpoint;
+
+typedef struct {
+    _Atomic uint32_t seq;           // SHMQ_MPMC: position this slot is ready for.
+    uint32_t len;                   // Bytes of message in data.
+    char data[];                    // slotsize bytes.
+} shmq_slot;
+
+typedef struct {
+    _Atomic uint32_t magic;         // 0 while being set up, then SHMQ_MAGIC, then SHMQ_DEAD.
+    uint32_t kind;
+    uint32_t slots, mask, slotsize, stride; // stride: bytes per slot including its header.
+    uint64_t total;                 // Messages the producers will send in all.
+    int32_t creator;                // pid of the process that created the queue.
+    uint32_t producers;             // Producer processes that will send.
+    _Atomic uint32_t finished;      // Producers that have sent everything (shmq_done).
+    _Alignas(SHMQ_LINE) _Atomic uint32_t head; // Next position to read.
+    uint32_t cachedtail;            // SPSC consumer's copy of tail.
+    _Atomic uint64_t claimed;       // Messages consumers have claimed (see shmq_claim).
+    _Alignas(SHMQ_LINE) _Atomic uint32_t tail; // Next position to write.
+    uint32_t cachedhead;            // SPSC producer's copy of head.
+    _Alignas(SHMQ_LINE) shmq_waitpoint notempty;
+    _Alignas(SHMQ_LINE) shmq_waitpoint notfull;
+    _Alignas(SHMQ_LINE) _Atomic uint64_t sleeps; // Futex waits, for the report.
+    _Alignas(SHMQ_LINE) char ring[]; // slots * stride bytes.
+} shmqueue;
+
+static inline shmq_slot *shmq_at(shmqueue *q, uint32_t pos) {
+    return (shmq_slot *)(q->ring + (size_t)(pos & q->mask) * q->stride);
+}
+
+static inline size_t shmq_bytes(uint32_t slots, uint32_t slotsize) {
+    size_t stride = (sizeof(shmq_slot) + slotsize + 7) / 8 * 8;
+    return sizeof(shmqueue) + (size_t)slots * stride;
+}
+
+// Wake processes sleeping on wp, if there are any.
+static inline void shmq_wake(shmq_waitpoint *wp) {
+    atomic_thread_fence(memory_order_seq_cst); // Order our publish before reading waiters.
+    if (atomic_load_explicit(&wp->waiters, memory_order_relaxed) > 0) {
+        atomic_fetch_add(&wp->epoch, 1);
+        syscall(SYS_futex, &wp->epoch, FUTEX_WAKE, INT_MAX, NULL, NULL, 0); // Shared, not _PRIVATE.
+    }
+}
+
+// Create (or re-create) the segment for key and initialise an empty queue
+// for total messages from the given number of producer processes.
+static inline shmqueue *shmq_create(key_t key, int kind, uint32_t slots, uint32_t slotsize, uint64_t total,
+                                    uint32_t producers, int *shmid) {
+    uint32_t s = 1, i;
+    while (s < slots) s <<= 1;      // Round up to a power of two.
+    int old = shmget(key, 0, 0666);
+    if (old != -1) {                // Left over from an earlier run.
+        shmqueue *o = shmat(old, NULL, 0);
+        if (o != (void *)-1) {      // Tell anyone still attached, and wake them to see it.
+            atomic_store(&o->magic, SHMQ_DEAD);
+            shmq_wake(&o->notempty);
+            shmq_wake(&o->notfull);
+            shmdt(o);
+        }
+        shmctl(old, IPC_RMID, NULL);
+    }
+    *shmid = shmget(key, shmq_bytes(s, slotsize), 0666 | IPC_CREAT | IPC_EXCL);
+    if (*shmid == -1) return NULL;
+    shmqueue *q = shmat(*shmid, NULL, 0);
+    if (q == (void *)-1) return NULL;
+    q->kind = kind;
+    q->slots = s;
+    q->mask = s - 1;
+    q->slotsize = slotsize;
+    q->stride = (sizeof(shmq_slot) + slotsize + 7) / 8 * 8;
+    q->total = total;
+    q->creator = getpid();
+    q->producers = producers;
+    atomic_init(&q->finished, 0);
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    q->cachedhead = q->cachedtail = 0;
+    atomic_init(&q->claimed, 0);
+    atomic_init(&q->notempty.epoch, 0);
+    atomic_init(&q->notempty.waiters, 0);
+    atomic_init(&q->notfull.epoch, 0);
+    atomic_init(&q->notfull.waiters, 0);
+    atomic_init(&q->sleeps, 0);
+    for (i = 0; i < s; i++)
+        atomic_init(&shmq_at(q, i)->seq, i); // Slot i is free for position i.
+    atomic_store_explicit(&q->magic, SHMQ_MAGIC, memory_order_release); // Last: attachers wait for this.
+    return q;
+}
+
+// Attach to a queue another process created; NULL if there is none yet (or
+// it is being replaced).
+static inline shmqueue *shmq_attach(key_t key, int *shmid) {
+    uint32_t magic;
+    *shmid = shmget(key, 0, 0666);
+    if (*shmid == -1) return NULL;
+    shmqueue *q = shmat(*shmid, NULL, 0);
+    if (q == (void *)-1) return NULL;
+    while ((magic = atomic_load_explicit(&q->magic, memory_order_acquire)) == 0)
+        usleep(1000);               // Creator still initialising.
+    if (magic != SHMQ_MAGIC) {
+        shmdt(q);
+        return NULL;
+    }
+    return q;
+}
+
+// A producer process calls this once it has committed all its messages.
+static inline void shmq_done(shmqueue *q) {
+    atomic_fetch_add(&q->finished, 1);
+}
+
+// True if q has been replaced, or its creator is gone without all producers
+// having finished: an interrupted run whose remaining messages never come.
+static inline int shmq_stale(shmqueue *q) {
+    if (atomic_load(&q->magic) != SHMQ_MAGIC) return 1;
+    return atomic_load(&q->finished) < q->producers && kill(q->creator, 0) == -1 && errno == ESRCH;
+}
+
+// Non-blocking: claim the next free slot for writing. Returns where to put the
+// message (up to slotsize bytes) and its position, or NULL if the queue is full.
+static inline void *shmq_tryreserve(shmqueue *q, uint32_t *pos) {
+    uint32_t p = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    if (q->kind == SHMQ_SPSC) {
+        if (p - q->cachedhead == q->slots) { // Copy says full: look at the real head.
+            q->cachedhead = atomic_load_explicit(&q->head, memory_order_acquire);
+            if (p - q->cachedhead == q->slots) return NULL;
+        }
+        *pos = p;
+        return shmq_at(q, p)->data;
+    }
+    while (1) {                     // SHMQ_MPMC
+        int32_t dif = (int32_t)(atomic_load_explicit(&shmq_at(q, p)->seq, memory_order_acquire) - p);
+        if (dif == 0) {             // Free for this position: try to claim it.
+            if (atomic_compare_exchange_weak_explicit(&q->tail, &p, p + 1, memory_order_relaxed,
+                                                      memory_order_relaxed))
+                break;
+        } else if (dif < 0) {
+            return NULL;            // Still holds a message from one lap ago: full.
+        } else {
+            p = atomic_load_explicit(&q->tail, memory_order_relaxed);
+        }
+    }
+    *pos = p;
+    return shmq_at(q, p)->data;
+}
+
+// Non-blocking: claim the oldest message for reading. Returns it and sets its
+// position and length, or NULL if the queue is empty.
+static inline void *shmq_trypeek(shmqueue *q, uint32_t *pos, uint32_t *len) {
+    uint32_t p = atomic_load_explicit(&q->head, memory_order_relaxed);
+    if (q->kind == SHMQ_SPSC) {
+        if (p == q->cachedtail) {   // Copy says empty: look at the real tail.
+            q->cachedtail = atomic_load_explicit(&q->tail, memory_order_acquire);
+            if (p == q->cachedtail) return NULL;
+        }
+    } else {
+        while (1) {                 // SHMQ_MPMC
+            int32_t dif = (int32_t)(atomic_load_explicit(&shmq_at(q, p)->seq, memory_order_acquire) - (p + 1));
+            if (dif == 0) {
+                if (atomic_compare_exchange_weak_explicit(&q->head, &p, p + 1, memory_order_relaxed,
+                                                          memory_order_relaxed))
+                    break;
+            } else if (dif < 0) {
+                return NULL;        // Not written yet: empty.
+            } else {
+                p = atomic_load_explicit(&q->head, memory_order_relaxed);
+            }
+        }
+    }
+    *pos = p;
+    *len = shmq_at(q, p)->len;
+    return shmq_at(q, p)->data;
+}
+
+// Sleep on wp until woken. The caller registers as a waiter and retries once
+// before calling this, so a wake in between cannot be missed. A producer that
+// dies wakes nobody, so sleeps are capped at SHMQ_NAP ns and the caller
+// checks shmq_stale again.
+static inline void shmq_sleep(shmqueue *q, shmq_waitpoint *wp, uint32_t epoch) {
+    struct timespec nap = {0, SHMQ_NAP};
+    atomic_fetch_add_explicit(&q->sleeps, 1, memory_order_relaxed);
+    syscall(SYS_futex, &wp->epoch, FUTEX_WAIT, epoch, &nap, NULL, 0);
+}
+
+// Blocking reserve: waits for a free slot. Returns NULL if the queue has
+// been replaced by a new one while waiting.
+static inline void *shmq_reserve(shmqueue *q, uint32_t *pos) {
+    void *p;
+    int spins = 0;
+    while (!(p = shmq_tryreserve(q, pos))) {
+        if (++spins < SHMQ_SPIN) continue;
+        if (atomic_load(&q->magic) != SHMQ_MAGIC) return NULL;
+        uint32_t e = atomic_load(&q->notfull.epoch);
+        atomic_fetch_add(&q->notfull.waiters, 1);
+        if (!(p = shmq_tryreserve(q, pos))) shmq_sleep(q, &q->notfull, e);
+        atomic_fetch_sub(&q->notfull.waiters, 1);
+        if (p) break;
+    }
+    return p;
+}
+
+// Publish the message written into a reserved slot.
+static inline void shmq_commit(shmqueue *q, uint32_t pos, uint32_t len) {
+    shmq_at(q, pos)->len = len;
+    if (q->kind == SHMQ_SPSC)
+        atomic_store_explicit(&q->tail, pos + 1, memory_order_release);
+    else
+        atomic_store_explicit(&shmq_at(q, pos)->seq, pos + 1, memory_order_release); // Ready to read.
+    shmq_wake(&q->notempty);
+}
+
+// Blocking peek: waits for a message. Returns NULL if the queue turns out
+// to be stale (see shmq_stale) while waiting.
+static inline void *shmq_peek(shmqueue *q, uint32_t *pos, uint32_t *len) {
+    void *p;
+    int spins = 0;
+    while (!(p = shmq_trypeek(q, pos, len))) {
+        if (++spins < SHMQ_SPIN) continue;
+        if (shmq_stale(q)) return NULL;
+        uint32_t e = atomic_load(&q->notempty.epoch);
+        atomic_fetch_add(&q->notempty.waiters, 1);
+        if (!(p = shmq_trypeek(q, pos, len))) shmq_sleep(q, &q->notempty, e);
+        atomic_fetch_sub(&q->notempty.waiters, 1);
+        if (p) break;
+    }
+    return p;
+}
+
+// Hand a read slot back to the producers.
+static inline void shmq_release(shmqueue *q, uint32_t pos) {
+    if (q->kind == SHMQ_SPSC)
+        atomic_store_explicit(&q->head, pos + 1, memory_order_release);
+    else
+        atomic_store_explicit(&shmq_at(q, pos)->seq, pos + q->slots, memory_order_release); // Free for next lap.
+    shmq_wake(&q->notfull);
+}
+
+// Consumers call this before each peek: it returns 0 once every message the
+// producers will send has been claimed, so no consumer waits for one that
+// will never come.
+static inline int shmq_claim(shmqueue *q) {
+    return atomic_fetch_add(&q->claimed, 1) < q->total;
+}
+
+#endif